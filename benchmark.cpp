@@ -0,0 +1,361 @@
+#include "benchmark.hpp"
+#include "global.hpp"
+#include "main.hpp"
+#include "pngImage.hpp"
+#include "pipeline.hpp"
+#include "renderer.hpp"
+#include "spriteKernels.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <iostream>
+
+namespace vulkan {
+    static const char* motionName(SpriteMotion motion) {
+        return motion == SpriteMotion::Cpu ? "cpu" : "gpu";
+    }
+
+    static const char* geometryName(SpriteGeometry geometry) {
+        return geometry == SpriteGeometry::Model ? "model" : "pulled";
+    }
+
+    static double elapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    static void summarize(std::vector<double> samples, double& average, double& p99) {
+        if (samples.empty()) {
+            return;
+        }
+        std::sort(samples.begin(), samples.end());
+        double total = 0.0;
+        for (double sample : samples) {
+            total += sample;
+        }
+        average = total / samples.size();
+        p99 = samples[std::min(samples.size() - 1, (samples.size() * 99) / 100)];
+    }
+
+    static std::vector<size_t> parseCounts(const std::string& list) {
+        std::vector<size_t> counts;
+        std::stringstream stream{ list };
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            counts.push_back(static_cast<size_t>(std::stoull(item)));
+        }
+        return counts;
+    }
+
+    BenchmarkOptions Benchmark::parseOptions(int argc, char* argv[]) {
+        BenchmarkOptions options;
+        for (int i = 0; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--sprites" && hasValue) {
+                options.spriteCounts = parseCounts(argv[++i]);
+            }
+            else if (arg == "--frames" && hasValue) {
+                options.frames = static_cast<uint32_t>(std::stoul(argv[++i]));
+            }
+            else if (arg == "--warmup" && hasValue) {
+                options.warmupFrames = static_cast<uint32_t>(std::stoul(argv[++i]));
+            }
+            else if (arg == "--motion" && hasValue) {
+                std::string motion = argv[++i];
+                if (motion == "cpu") {
+                    options.motions = { SpriteMotion::Cpu };
+                }
+                else if (motion == "gpu") {
+                    options.motions = { SpriteMotion::Gpu };
+                }
+                else if (motion != "both") {
+                    throw std::runtime_error("unknown benchmark motion: " + motion);
+                }
+            }
+            else if (arg == "--geometry" && hasValue) {
+                std::string geometry = argv[++i];
+                if (geometry == "model") {
+                    options.geometries = { SpriteGeometry::Model };
+                }
+                else if (geometry == "pulled") {
+                    options.geometries = { SpriteGeometry::VertexPulling };
+                }
+                else if (geometry != "both") {
+                    throw std::runtime_error("unknown benchmark geometry: " + geometry);
+                }
+            }
+            else if (arg == "--format" && hasValue) {
+                std::string format = argv[++i];
+                if (format == "compact") {
+                    options.spriteFormat = SpriteFormat::Compact;
+                }
+                else if (format != "full") {
+                    throw std::runtime_error("unknown benchmark sprite format: " + format);
+                }
+            }
+            else if (arg == "--models" && hasValue) {
+                options.modelCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+            }
+            else if (arg == "--static" && hasValue) {
+                options.staticFraction = std::stof(argv[++i]);
+                if (options.staticFraction < 0.0f || options.staticFraction > 1.0f) {
+                    throw std::runtime_error("benchmark static fraction must be in [0, 1]!");
+                }
+            }
+            else if (arg == "--order" && hasValue) {
+                std::string order = argv[++i];
+                if (order == "sorted") {
+                    options.spriteOrder = SpriteOrder::Sorted;
+                }
+                else if (order != "unsorted") {
+                    throw std::runtime_error("unknown benchmark sprite order: " + order);
+                }
+            }
+            else if (arg == "--size" && hasValue) {
+                std::string size = argv[++i];
+                size_t separator = size.find('x');
+                if (separator == std::string::npos) {
+                    throw std::runtime_error("benchmark size must be WxH: " + size);
+                }
+                options.width = static_cast<uint32_t>(std::stoul(size.substr(0, separator)));
+                options.height = static_cast<uint32_t>(std::stoul(size.substr(separator + 1)));
+            }
+            else if (arg == "--windowed") {
+                options.headless = false;
+            }
+            else if (arg == "--capture") {
+                options.capture = true;
+            }
+            else if (arg == "--out" && hasValue) {
+                options.outputPrefix = argv[++i];
+            }
+        }
+        return options;
+    }
+
+    bool Benchmark::run() {
+        // An odd count exercises the scalar tail behind every SIMD block.
+        kernelsMatch = verifySpriteKernels(100003);
+
+        Window window{ static_cast<int>(options.width), static_cast<int>(options.height), "Benchmark", options.headless };
+        Device device{ window };
+
+        bool succeeded = kernelsMatch;
+        for (SpriteMotion motion : options.motions) {
+            if (motion == SpriteMotion::Gpu && options.spriteFormat == SpriteFormat::Compact) {
+                std::cout << "Benchmark: skipping gpu motion, compact sprites have no speed to integrate" << std::endl;
+                continue;
+            }
+            for (SpriteGeometry geometry : options.geometries) {
+                for (size_t spriteCount : options.spriteCounts) {
+                    std::cout << "Benchmark: " << spriteCount << " sprites, " << motionName(motion) << " motion, "
+                        << geometryName(geometry) << " geometry" << std::endl;
+                    results.push_back(runStep(window, device, spriteCount, motion, geometry));
+                    if (!results.back().error.empty()) {
+                        // Larger counts would only fail the same way.
+                        std::cerr << "Benchmark step failed: " << results.back().error << std::endl;
+                        succeeded = false;
+                        break;
+                    }
+                }
+            }
+        }
+
+        bool written = writeCsv(options.outputPrefix + ".csv") && writeJson(options.outputPrefix + ".json", device.properties.deviceName);
+        return succeeded && written;
+    }
+
+    bool Benchmark::verifySpriteKernels(size_t spriteCount) {
+        bool allMatch = true;
+        for (const SpriteKernelCheck& check : compareSpriteKernels(spriteCount)) {
+            std::string result = !check.supported ? "unsupported"
+                : check.kernel == SpriteKernel::Scalar ? "reference"
+                : check.matchesScalar ? "match" : "MISMATCH";
+            allMatch = allMatch && (!check.supported || check.matchesScalar);
+            kernelChecks.push_back(std::string(spriteKernelName(check.kernel)) + ": " + result);
+        }
+
+        for (const auto& check : kernelChecks) {
+            std::cout << "Sprite kernel " << check << std::endl;
+        }
+        return allMatch;
+    }
+
+    BenchmarkResult Benchmark::runStep(Window& window, Device& device, size_t spriteCount, SpriteMotion motion, SpriteGeometry geometry) {
+        BenchmarkResult result{};
+        result.spriteCount = spriteCount;
+        result.motion = motion;
+        result.geometry = geometry;
+
+        try {
+            Renderer renderer{ window, device };
+            Pipeline assets{ device, "triangle.vert.spv", "triangle.frag.spv", renderer.getSwapChainRenderPass() };
+
+            auto initializeStart = std::chrono::steady_clock::now();
+            assets.loadSprites(spriteCount, options.modelCount);
+            size_t staticCount = static_cast<size_t>(options.staticFraction * static_cast<float>(sprites.size()));
+            for (size_t i = 0; i < staticCount; i++) {
+                sprites.velocities()[i] = glm::vec2(0.0f);
+            }
+            RenderSystem renderSystem{ device, window, renderer.getSwapChainRenderPass(), assets.getDescriptorSetLayout(),
+                renderer.getFramesInFlight(), options.spriteFormat, geometry, options.spriteOrder };
+            renderSystem.setSpriteMotion(motion);
+            renderSystem.setProfiler(&renderer.getProfiler());
+            renderSystem.initialize();
+            result.initializeMilliseconds = elapsedMilliseconds(initializeStart);
+
+            // Fixed step so every run integrates the same trajectories.
+            const float deltaTime = 1.0f / 60.0f;
+            std::vector<double> frameTimes;
+            std::vector<double> updateTimes;
+            double uploadBytes = 0.0;
+            for (uint32_t frame = 0; frame < options.warmupFrames + options.frames; frame++) {
+                if (frame == options.warmupFrames) {
+                    renderer.getProfiler().clearHistory();
+                }
+
+                auto frameStart = std::chrono::steady_clock::now();
+                VkCommandBuffer commandBuffer = renderer.beginFrame();
+                if (!commandBuffer) {
+                    continue;
+                }
+                if (options.capture && frame + 1 == options.warmupFrames + options.frames) {
+                    renderer.requestCapture();
+                }
+                auto updateStart = std::chrono::steady_clock::now();
+                renderSystem.updateSprites(commandBuffer, renderer.getFrameIndex(), deltaTime);
+                double updateTime = elapsedMilliseconds(updateStart);
+
+                renderer.beginSwapChainRenderPass(commandBuffer);
+                renderSystem.renderSprites(commandBuffer);
+                renderer.endSwapChainRenderPass(commandBuffer);
+                renderer.endFrame();
+
+                if (frame >= options.warmupFrames) {
+                    frameTimes.push_back(elapsedMilliseconds(frameStart));
+                    updateTimes.push_back(updateTime);
+                    uploadBytes += static_cast<double>(renderSystem.getUploadedBytes());
+                }
+            }
+            // Waits for the device, which the profiler and allocator reads below also rely on.
+            renderer.flushCaptures();
+            for (const auto& captured : renderer.takeCapturedFrames()) {
+                std::string capturePath = options.outputPrefix + "_" + std::to_string(spriteCount) + "_" + motionName(motion)
+                    + "_" + geometryName(geometry) + ".png";
+                if (writePng(capturePath, captured.width, captured.height, captured.rgba)) {
+                    std::cout << "Captured frame " << captured.frameNumber << " to " << capturePath << std::endl;
+                }
+            }
+
+            result.frames = static_cast<uint32_t>(frameTimes.size());
+            summarize(frameTimes, result.frameAvgMilliseconds, result.frameP99Milliseconds);
+            summarize(updateTimes, result.cpuUpdateAvgMilliseconds, result.cpuUpdateP99Milliseconds);
+            result.uploadBytesAvg = frameTimes.empty() ? 0.0 : uploadBytes / frameTimes.size();
+
+            const GpuProfiler& profiler = renderer.getProfiler();
+            GpuScopeStats gpuFrame = profiler.getStats("frame");
+            result.gpuFrameAvgMilliseconds = gpuFrame.avgMilliseconds;
+            result.gpuFrameP99Milliseconds = gpuFrame.p99Milliseconds;
+            result.gpuUploadAvgMilliseconds = profiler.getStats("sprite upload").avgMilliseconds;
+            result.gpuMotionAvgMilliseconds = profiler.getStats("sprite motion").avgMilliseconds;
+            result.gpuCullAvgMilliseconds = profiler.getStats("cull").avgMilliseconds;
+            result.gpuSortAvgMilliseconds = profiler.getStats("sort").avgMilliseconds;
+            result.gpuDrawAvgMilliseconds = profiler.getStats("render sprites").avgMilliseconds;
+
+            MemoryStats memory = device.getAllocator().getStats();
+            result.allocatedBytes = memory.usedBytes;
+            result.reservedBytes = memory.blockBytes;
+
+            sprites.clear();
+        }
+        catch (const std::exception& e) {
+            vkDeviceWaitIdle(device.device());
+            sprites.clear();
+            result.error = e.what();
+        }
+        return result;
+    }
+
+    bool Benchmark::writeCsv(const std::string& filepath) const {
+        std::ofstream file{ filepath, std::ios::trunc };
+        file << "sprites,motion,geometry,frames,init_ms,frame_avg_ms,frame_p99_ms,cpu_update_avg_ms,cpu_update_p99_ms,upload_bytes_avg,"
+            "gpu_frame_avg_ms,gpu_frame_p99_ms,gpu_upload_avg_ms,gpu_motion_avg_ms,gpu_cull_avg_ms,gpu_sort_avg_ms,gpu_draw_avg_ms,"
+            "allocated_bytes,reserved_bytes,error\n";
+        for (const auto& result : results) {
+            file << result.spriteCount << ',' << motionName(result.motion) << ',' << geometryName(result.geometry) << ',' << result.frames << ','
+                << result.initializeMilliseconds << ',' << result.frameAvgMilliseconds << ',' << result.frameP99Milliseconds << ','
+                << result.cpuUpdateAvgMilliseconds << ',' << result.cpuUpdateP99Milliseconds << ',' << result.uploadBytesAvg << ','
+                << result.gpuFrameAvgMilliseconds << ',' << result.gpuFrameP99Milliseconds << ','
+                << result.gpuUploadAvgMilliseconds << ',' << result.gpuMotionAvgMilliseconds << ','
+                << result.gpuCullAvgMilliseconds << ',' << result.gpuSortAvgMilliseconds << ',' << result.gpuDrawAvgMilliseconds << ','
+                << result.allocatedBytes << ',' << result.reservedBytes << ",\"" << result.error << "\"\n";
+        }
+        if (!file) {
+            std::cerr << "Failed to write benchmark results to " << filepath << std::endl;
+            return false;
+        }
+        std::cout << "Benchmark results written to " << filepath << std::endl;
+        return true;
+    }
+
+    bool Benchmark::writeJson(const std::string& filepath, const std::string& deviceName) const {
+        auto quoted = [](const std::string& text) {
+            std::string escaped = "\"";
+            for (char c : text) {
+                if (c == '"' || c == '\\') {
+                    escaped += '\\';
+                }
+                escaped += (static_cast<unsigned char>(c) < 0x20) ? ' ' : c;
+            }
+            return escaped + "\"";
+        };
+
+        std::ofstream file{ filepath, std::ios::trunc };
+        file << "{\n  \"device\": " << quoted(deviceName) << ",\n"
+            << "  \"headless\": " << (options.headless ? "true" : "false") << ",\n"
+            << "  \"spriteFormat\": " << quoted(options.spriteFormat == SpriteFormat::Compact ? "compact" : "full") << ",\n"
+            << "  \"modelCount\": " << options.modelCount << ",\n"
+            << "  \"framesInFlight\": " << frameSettings.framesInFlight << ",\n"
+            << "  \"staticFraction\": " << options.staticFraction << ",\n"
+            << "  \"spriteOrder\": " << quoted(options.spriteOrder == SpriteOrder::Sorted ? "sorted" : "unsorted") << ",\n"
+            << "  \"width\": " << options.width << ",\n  \"height\": " << options.height << ",\n"
+            << "  \"spriteKernel\": " << quoted(spriteKernelName(activeSpriteKernel())) << ",\n"
+            << "  \"kernelsMatch\": " << (kernelsMatch ? "true" : "false") << ",\n  \"kernelChecks\": [";
+        for (size_t i = 0; i < kernelChecks.size(); i++) {
+            file << (i ? ", " : "") << quoted(kernelChecks[i]);
+        }
+        file << "],\n  \"results\": [";
+        for (size_t i = 0; i < results.size(); i++) {
+            const auto& result = results[i];
+            file << (i ? "," : "") << "\n    { \"sprites\": " << result.spriteCount
+                << ", \"motion\": " << quoted(motionName(result.motion))
+                << ", \"geometry\": " << quoted(geometryName(result.geometry))
+                << ", \"frames\": " << result.frames
+                << ", \"initMs\": " << result.initializeMilliseconds
+                << ", \"frameAvgMs\": " << result.frameAvgMilliseconds
+                << ", \"frameP99Ms\": " << result.frameP99Milliseconds
+                << ", \"cpuUpdateAvgMs\": " << result.cpuUpdateAvgMilliseconds
+                << ", \"cpuUpdateP99Ms\": " << result.cpuUpdateP99Milliseconds
+                << ", \"uploadBytesAvg\": " << result.uploadBytesAvg
+                << ", \"gpuFrameAvgMs\": " << result.gpuFrameAvgMilliseconds
+                << ", \"gpuFrameP99Ms\": " << result.gpuFrameP99Milliseconds
+                << ", \"gpuUploadAvgMs\": " << result.gpuUploadAvgMilliseconds
+                << ", \"gpuMotionAvgMs\": " << result.gpuMotionAvgMilliseconds
+                << ", \"gpuCullAvgMs\": " << result.gpuCullAvgMilliseconds
+                << ", \"gpuSortAvgMs\": " << result.gpuSortAvgMilliseconds
+                << ", \"gpuDrawAvgMs\": " << result.gpuDrawAvgMilliseconds
+                << ", \"allocatedBytes\": " << result.allocatedBytes
+                << ", \"reservedBytes\": " << result.reservedBytes
+                << ", \"error\": " << quoted(result.error) << " }";
+        }
+        file << "\n  ]\n}\n";
+        if (!file) {
+            std::cerr << "Failed to write benchmark results to " << filepath << std::endl;
+            return false;
+        }
+        std::cout << "Benchmark results written to " << filepath << std::endl;
+        return true;
+    }
+}
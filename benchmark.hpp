@@ -0,0 +1,75 @@
+#pragma once
+#include "device.hpp"
+#include "renderSystem.hpp"
+#include "window.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vulkan {
+    struct BenchmarkOptions {
+        std::vector<size_t> spriteCounts = { 1000, 10000, 100000, 1000000, 10000000 };
+        std::vector<SpriteMotion> motions = { SpriteMotion::Cpu, SpriteMotion::Gpu };
+        std::vector<SpriteGeometry> geometries = { SpriteGeometry::Model, SpriteGeometry::VertexPulling };
+        SpriteFormat spriteFormat = SpriteFormat::Full; // Compact runs only the CPU motion steps
+        uint32_t modelCount = 1; // sprites cycle through this many models, all drawn by one multi-draw
+        SpriteOrder spriteOrder = SpriteOrder::Unsorted;
+        float staticFraction = 0.0f; // leading share of sprites given zero velocity, so CPU motion skips their chunks
+        uint32_t frames = 200;
+        uint32_t warmupFrames = 20;
+        uint32_t width = 1280;
+        uint32_t height = 720;
+        bool headless = true;
+        bool capture = false; // save the last frame of each step as <prefix>_<sprites>_<motion>_<geometry>.png
+        std::string outputPrefix = "benchmark"; // writes <prefix>.csv and <prefix>.json
+    };
+
+    struct BenchmarkResult {
+        size_t spriteCount = 0;
+        SpriteMotion motion = SpriteMotion::Gpu;
+        SpriteGeometry geometry = SpriteGeometry::Model;
+        uint32_t frames = 0;
+        double initializeMilliseconds = 0.0;
+        double frameAvgMilliseconds = 0.0;
+        double frameP99Milliseconds = 0.0;
+        double cpuUpdateAvgMilliseconds = 0.0; // updateSprites on the host, including CPU integration
+        double cpuUpdateP99Milliseconds = 0.0;
+        double uploadBytesAvg = 0.0; // sprite records and draw info copied per frame
+        double gpuFrameAvgMilliseconds = 0.0;
+        double gpuFrameP99Milliseconds = 0.0;
+        double gpuUploadAvgMilliseconds = 0.0;
+        double gpuMotionAvgMilliseconds = 0.0;
+        double gpuCullAvgMilliseconds = 0.0;
+        double gpuSortAvgMilliseconds = 0.0; // part of the cull time
+        double gpuDrawAvgMilliseconds = 0.0;
+        VkDeviceSize allocatedBytes = 0;
+        VkDeviceSize reservedBytes = 0;
+        std::string error;
+    };
+
+    // Sweeps sprite counts through RenderSystem::initialize, updateSprites and renderSprites for a fixed
+    // number of frames, headless by default so it runs on lavapipe or SwiftShader.
+    class Benchmark {
+    public:
+        explicit Benchmark(const BenchmarkOptions& options) : options{ options } {}
+
+        // Parses --sprites a,b,c  --frames N  --warmup N  --motion cpu|gpu|both  --geometry model|pulled|both
+        // --format full|compact  --models N  --order unsorted|sorted  --static F  --size WxH  --windowed  --capture  --out prefix.
+        static BenchmarkOptions parseOptions(int argc, char* argv[]);
+
+        // Returns false if a kernel disagreed with the scalar path or a step failed.
+        bool run();
+        const std::vector<BenchmarkResult>& getResults() const { return results; }
+
+    private:
+        bool verifySpriteKernels(size_t spriteCount);
+        BenchmarkResult runStep(Window& window, Device& device, size_t spriteCount, SpriteMotion motion, SpriteGeometry geometry);
+        bool writeCsv(const std::string& filepath) const;
+        bool writeJson(const std::string& filepath, const std::string& deviceName) const;
+
+        BenchmarkOptions options;
+        std::vector<BenchmarkResult> results;
+        std::vector<std::string> kernelChecks;
+        bool kernelsMatch = true;
+    };
+}
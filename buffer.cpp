@@ -0,0 +1,94 @@
+#include "buffer.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace vulkan {
+
+    VkDeviceSize Buffer::getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment) {
+        if (minOffsetAlignment > 0) {
+            return (instanceSize + minOffsetAlignment - 1) & ~(minOffsetAlignment - 1);
+        }
+        return instanceSize;
+    }
+
+    Buffer::Buffer(
+        Device& device,
+        VkDeviceSize instanceSize,
+        uint32_t instanceCount,
+        VkBufferUsageFlags usageFlags,
+        VkMemoryPropertyFlags memoryPropertyFlags,
+        VkDeviceSize minOffsetAlignment)
+        : device{ device }, instanceCount{ instanceCount }, instanceSize{ instanceSize } {
+        alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
+        bufferSize = alignmentSize * instanceCount;
+        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+    }
+
+    Buffer::~Buffer() {
+        unmap();
+        device.destroyBuffer(buffer, memory);
+    }
+
+    VkResult Buffer::map() {
+        if (!memory.mapped) {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        mapped = memory.mapped;
+        return VK_SUCCESS;
+    }
+
+    void Buffer::unmap() {
+        // The allocator's block stays mapped; other allocations in it still use the mapping.
+        mapped = nullptr;
+    }
+
+    void Buffer::write(const void* data, VkDeviceSize size, VkDeviceSize offset) {
+        assert(mapped && "Cannot write to an unmapped buffer");
+        if (size == VK_WHOLE_SIZE) {
+            size = bufferSize - offset;
+        }
+        memcpy(static_cast<char*>(mapped) + offset, data, static_cast<size_t>(size));
+    }
+
+    VkMappedMemoryRange Buffer::mappedRange(VkDeviceSize size, VkDeviceSize offset) const {
+        // The allocator pads non-coherent allocations to whole atoms, so the full range is always legal to flush.
+        VkMappedMemoryRange range{};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = memory.memory;
+        if (size == VK_WHOLE_SIZE) {
+            range.offset = memory.offset;
+            range.size = memory.size;
+        }
+        else {
+            VkDeviceSize atom = device.properties.limits.nonCoherentAtomSize;
+            VkDeviceSize begin = (memory.offset + offset) / atom * atom;
+            VkDeviceSize end = std::min(memory.offset + memory.size, (memory.offset + offset + size + atom - 1) / atom * atom);
+            range.offset = begin;
+            range.size = end - begin;
+        }
+        return range;
+    }
+
+    VkResult Buffer::flush(VkDeviceSize size, VkDeviceSize offset) {
+        VkMappedMemoryRange range = mappedRange(size, offset);
+        return vkFlushMappedMemoryRanges(device.device(), 1, &range);
+    }
+
+    VkResult Buffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
+        VkMappedMemoryRange range = mappedRange(size, offset);
+        return vkInvalidateMappedMemoryRanges(device.device(), 1, &range);
+    }
+
+    VkDescriptorBufferInfo Buffer::descriptorInfo(VkDeviceSize size, VkDeviceSize offset) const {
+        return VkDescriptorBufferInfo{ buffer, offset, size };
+    }
+
+    void Buffer::writeToIndex(const void* data, uint32_t index) {
+        write(data, instanceSize, index * alignmentSize);
+    }
+
+    VkDescriptorBufferInfo Buffer::descriptorInfoForIndex(uint32_t index) const {
+        return descriptorInfo(alignmentSize, index * alignmentSize);
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "device.hpp"
+#include <vulkan/vulkan.h>
+
+namespace vulkan {
+
+    // A VkBuffer of instanceCount equally sized instances, each padded to minOffsetAlignment,
+    // suballocated through the device's MemoryAllocator.
+    class Buffer {
+    public:
+        Buffer(
+            Device& device,
+            VkDeviceSize instanceSize,
+            uint32_t instanceCount,
+            VkBufferUsageFlags usageFlags,
+            VkMemoryPropertyFlags memoryPropertyFlags,
+            VkDeviceSize minOffsetAlignment = 1);
+        ~Buffer();
+
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        // Host-visible allocations are mapped for their whole lifetime, so map only hands out the pointer.
+        VkResult map();
+        void unmap();
+
+        void write(const void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+        // Only needed for memory without HOST_COHERENT; offsets are relative to the buffer.
+        VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+        VkResult invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+        VkDescriptorBufferInfo descriptorInfo(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const;
+
+        void writeToIndex(const void* data, uint32_t index);
+        VkDescriptorBufferInfo descriptorInfoForIndex(uint32_t index) const;
+
+        VkBuffer getBuffer() const { return buffer; }
+        void* getMappedMemory() const { return mapped; }
+        uint32_t getInstanceCount() const { return instanceCount; }
+        VkDeviceSize getInstanceSize() const { return instanceSize; }
+        VkDeviceSize getAlignmentSize() const { return alignmentSize; }
+        VkDeviceSize getBufferSize() const { return bufferSize; }
+
+    private:
+        static VkDeviceSize getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
+        VkMappedMemoryRange mappedRange(VkDeviceSize size, VkDeviceSize offset) const;
+
+        Device& device;
+        void* mapped = nullptr;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        MemoryAllocation memory;
+
+        VkDeviceSize bufferSize;
+        uint32_t instanceCount;
+        VkDeviceSize instanceSize;
+        VkDeviceSize alignmentSize;
+    };
+}
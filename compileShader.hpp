@@ -1,4 +0,0 @@
-#ifndef COMPILE_HPP
-#define COMPILE_HPP
-bool compile();
-#endif
@@ -0,0 +1,79 @@
+#include "computePipeline.hpp"
+#include "pipeline.hpp"
+#include "global.hpp"
+#include <stdexcept>
+#include <iostream>
+
+namespace vulkan {
+    ComputePipeline::ComputePipeline(Device& device, const std::string& compFilepath, VkDescriptorSetLayout descriptorSetLayout, uint32_t pushConstantSize,
+        const VkSpecializationInfo* specialization)
+        : device{ device } {
+        createPipelineLayout(descriptorSetLayout, pushConstantSize);
+        createComputePipeline(compFilepath, specialization);
+    }
+
+    ComputePipeline::~ComputePipeline() {
+        vkDestroyShaderModule(device.device(), compShaderModule, nullptr);
+        vkDestroyPipeline(device.device(), computePipeline, nullptr);
+        vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+        std::cout << "Destroying ComputePipeline" << std::endl;
+    }
+
+    void ComputePipeline::createPipelineLayout(VkDescriptorSetLayout descriptorSetLayout, uint32_t pushConstantSize) {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = pushConstantSize;
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = pushConstantSize > 0 ? 1 : 0;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create compute pipeline layout!");
+        }
+    }
+
+    void ComputePipeline::createComputePipeline(const std::string& compFilepath, const VkSpecializationInfo* specialization) {
+        auto compCode = shaderArchive.getCode(compFilepath);
+
+        VkShaderModuleCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        createInfo.codeSize = compCode.size();
+        createInfo.pCode = reinterpret_cast<const uint32_t*>(compCode.data());
+
+        if (vkCreateShaderModule(device.device(), &createInfo, nullptr, &compShaderModule) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create compute shader module!");
+        }
+
+        VkPipelineShaderStageCreateInfo shaderStage{};
+        shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        shaderStage.module = compShaderModule;
+        shaderStage.pName = "main";
+        shaderStage.pSpecializationInfo = specialization;
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage = shaderStage;
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+        if (device.getPipelineCache().createComputePipeline(pipelineInfo, &computePipeline, compFilepath.c_str()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create compute pipeline!");
+        }
+        std::cout << "Compute pipeline created: " << compFilepath << std::endl;
+    }
+
+    void ComputePipeline::bind(VkCommandBuffer commandBuffer) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+    }
+
+    void ComputePipeline::dispatch(VkCommandBuffer commandBuffer, uint32_t invocationCount) {
+        uint32_t groupCount = (invocationCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+        vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+#include "device.hpp"
+
+namespace vulkan {
+    class ComputePipeline {
+    public:
+        ComputePipeline(Device& device, const std::string& compFilepath, VkDescriptorSetLayout descriptorSetLayout, uint32_t pushConstantSize,
+            const VkSpecializationInfo* specialization = nullptr);
+        ~ComputePipeline();
+
+        ComputePipeline(const ComputePipeline&) = delete;
+        ComputePipeline& operator=(const ComputePipeline&) = delete;
+
+        void bind(VkCommandBuffer commandBuffer);
+        void dispatch(VkCommandBuffer commandBuffer, uint32_t invocationCount);
+        VkPipelineLayout getPipelineLayout() { return pipelineLayout; }
+
+        static constexpr uint32_t WORKGROUP_SIZE = 256;
+
+    private:
+        void createPipelineLayout(VkDescriptorSetLayout descriptorSetLayout, uint32_t pushConstantSize);
+        void createComputePipeline(const std::string& compFilepath, const VkSpecializationInfo* specialization);
+
+        Device& device;
+        VkPipeline computePipeline;
+        VkShaderModule compShaderModule;
+        VkPipelineLayout pipelineLayout;
+    };
+}
@@ -0,0 +1,145 @@
+#include "cpuProfiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <iostream>
+
+namespace vulkan {
+    std::atomic<bool> CpuProfiler::enabledFlag{ false };
+
+    namespace {
+        struct Zone {
+            const char* name;
+            uint64_t begin;
+            uint64_t end;
+        };
+
+        struct ThreadRing {
+            uint32_t threadId;
+            std::atomic<const char*> threadName{ nullptr };
+            std::atomic<uint64_t> head{ 0 }; // zones ever written; slot = index % RING_SIZE
+            std::unique_ptr<Zone[]> zones{ new Zone[CpuProfiler::RING_SIZE] };
+        };
+
+        // Rings are registered once per thread and never freed, so zones from finished threads still export.
+        std::mutex registryMutex;
+        std::vector<std::unique_ptr<ThreadRing>> rings;
+
+        // The ring is allocated on the thread's first zone, so threads that never record while enabled cost nothing.
+        thread_local ThreadRing* threadRing = nullptr;
+        thread_local const char* threadName = nullptr;
+
+        ThreadRing& localRing() {
+            if (!threadRing) {
+                std::lock_guard<std::mutex> lock(registryMutex);
+                rings.push_back(std::make_unique<ThreadRing>());
+                threadRing = rings.back().get();
+                threadRing->threadId = static_cast<uint32_t>(rings.size());
+                threadRing->threadName.store(threadName, std::memory_order_relaxed);
+            }
+            return *threadRing;
+        }
+
+        const auto epoch = std::chrono::steady_clock::now();
+
+        void writeJsonString(std::ofstream& file, const char* text) {
+            file << '"';
+            for (const char* c = text; *c; c++) {
+                if (*c == '"' || *c == '\\') {
+                    file << '\\' << *c;
+                }
+                else if (static_cast<unsigned char>(*c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+                    file << escaped;
+                }
+                else {
+                    file << *c;
+                }
+            }
+            file << '"';
+        }
+    }
+
+    uint64_t CpuProfiler::now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void CpuProfiler::record(const char* name, uint64_t beginNanoseconds, uint64_t endNanoseconds) {
+        ThreadRing& ring = localRing();
+        uint64_t index = ring.head.load(std::memory_order_relaxed);
+        ring.zones[index % RING_SIZE] = { name, beginNanoseconds, endNanoseconds };
+        ring.head.store(index + 1, std::memory_order_release);
+    }
+
+    void CpuProfiler::setThreadName(const char* name) {
+        threadName = name;
+        if (threadRing) {
+            threadRing->threadName.store(name, std::memory_order_relaxed);
+        }
+    }
+
+    bool CpuProfiler::exportChromeTrace(const std::string& filepath) {
+        std::ofstream file{ filepath, std::ios::trunc };
+        if (!file.is_open()) {
+            std::cerr << "Failed to open trace file " << filepath << std::endl;
+            return false;
+        }
+
+        std::vector<ThreadRing*> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            for (auto& ring : rings) {
+                snapshot.push_back(ring.get());
+            }
+        }
+
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        size_t zoneCount = 0;
+        std::vector<Zone> zones;
+        for (ThreadRing* ring : snapshot) {
+            const char* trackName = ring->threadName.load(std::memory_order_relaxed);
+            if (trackName) {
+                file << (first ? "" : ",") << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << ring->threadId << ",\"args\":{\"name\":";
+                writeJsonString(file, trackName);
+                file << "}}";
+                first = false;
+            }
+
+            // Copy first, then drop any slot the owner may have started overwriting while we were reading.
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t oldest = head > RING_SIZE ? head - RING_SIZE : 0;
+            zones.clear();
+            for (uint64_t index = oldest; index < head; index++) {
+                zones.push_back(ring->zones[index % RING_SIZE]);
+            }
+            uint64_t headAfter = ring->head.load(std::memory_order_acquire);
+            uint64_t firstIntact = headAfter >= RING_SIZE ? headAfter - RING_SIZE + 1 : 0;
+            size_t skip = static_cast<size_t>(std::min<uint64_t>(firstIntact > oldest ? firstIntact - oldest : 0, zones.size()));
+
+            for (size_t i = skip; i < zones.size(); i++) {
+                const Zone& zone = zones[i];
+                file << (first ? "" : ",") << "\n{\"ph\":\"X\",\"name\":";
+                writeJsonString(file, zone.name);
+                file << ",\"pid\":1,\"tid\":" << ring->threadId
+                    << ",\"ts\":" << zone.begin / 1000 << '.' << (zone.begin % 1000) / 100
+                    << ",\"dur\":" << (zone.end - zone.begin) / 1000 << '.' << ((zone.end - zone.begin) % 1000) / 100 << "}";
+                first = false;
+                zoneCount++;
+            }
+        }
+        file << "\n]}\n";
+
+        if (!file) {
+            std::cerr << "Failed to write trace file " << filepath << std::endl;
+            return false;
+        }
+        std::cout << "Wrote " << zoneCount << " CPU zones from " << snapshot.size() << " threads to " << filepath << std::endl;
+        return true;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace vulkan {
+    // Scoped CPU zones recorded into one fixed-size ring per thread. Only the owning thread writes its ring,
+    // so recording takes no lock; a disabled profiler costs one relaxed load per zone.
+    // Rings keep the most recent RING_SIZE zones per thread and are written out as Chrome trace_event JSON.
+    class CpuProfiler {
+    public:
+        static constexpr size_t RING_SIZE = 1 << 16;
+
+        static void setEnabled(bool enabled) { enabledFlag.store(enabled, std::memory_order_relaxed); }
+        static bool isEnabled() { return enabledFlag.load(std::memory_order_relaxed); }
+
+        // Nanoseconds on a steady clock since the profiler was first used.
+        static uint64_t now();
+        // name must outlive the export; zones normally pass string literals.
+        static void record(const char* name, uint64_t beginNanoseconds, uint64_t endNanoseconds);
+        // Labels the calling thread's track in the trace.
+        static void setThreadName(const char* name);
+
+        // Writes every recorded zone as complete ("X") events; loads in chrome://tracing and Perfetto.
+        static bool exportChromeTrace(const std::string& filepath);
+
+    private:
+        static std::atomic<bool> enabledFlag;
+    };
+
+    class CpuZone {
+    public:
+        explicit CpuZone(const char* name) : name{ name }, active{ CpuProfiler::isEnabled() } {
+            if (active) {
+                begin = CpuProfiler::now();
+            }
+        }
+        ~CpuZone() {
+            if (active) {
+                CpuProfiler::record(name, begin, CpuProfiler::now());
+            }
+        }
+
+        CpuZone(const CpuZone&) = delete;
+        CpuZone& operator=(const CpuZone&) = delete;
+
+    private:
+        const char* name;
+        bool active;
+        uint64_t begin = 0;
+    };
+}
+
+#define CPU_ZONE_CONCAT_INNER(a, b) a##b
+#define CPU_ZONE_CONCAT(a, b) CPU_ZONE_CONCAT_INNER(a, b)
+#define CPU_ZONE(name) vulkan::CpuZone CPU_ZONE_CONCAT(cpuZone, __LINE__){ name }
@@ -1,4 +1,6 @@
 #include "device.hpp"
+#include "model.hpp"
+#include "global.hpp"
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -50,16 +52,31 @@ namespace vulkan {
         createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
+        allocator = std::make_unique<MemoryAllocator>(device_, physicalDevice);
+        pipelineCache = std::make_unique<PipelineCache>(device_, properties, "pipeline_cache.bin", pipelineCreationFeedback);
         createCommandPool();
     }
 
     Device::~Device() {
+        // The global store points at models and textures living in this device's memory; drop them with it.
+        sprites.clear();
+        meshPool.reset();
+        transferTimeline_.reset();
+        graphicsTimeline_.reset();
+        pipelineCache.reset();
+        allocator->printStats();
+        allocator.reset();
+        if (transferCommandPool != commandPool) {
+            vkDestroyCommandPool(device_, transferCommandPool, nullptr);
+        }
         vkDestroyCommandPool(device_, commandPool, nullptr);
         vkDestroyDevice(device_, nullptr);
         if (enableValidationLayers) {
             DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
         }
-        vkDestroySurfaceKHR(instance, surface_, nullptr);
+        if (surface_ != VK_NULL_HANDLE) {
+            vkDestroySurfaceKHR(instance, surface_, nullptr);
+        }
         vkDestroyInstance(instance, nullptr);
     }
 
@@ -113,6 +130,10 @@ namespace vulkan {
     }
 
     void Device::createSurface() {
+        if (isHeadless()) {
+            std::cout << "Headless: no window surface" << std::endl;
+            return;
+        }
         window.createWindowSurface(instance, &surface_);
     }
 
@@ -146,6 +167,9 @@ namespace vulkan {
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
         std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
+        if (indices.transferFamilyHasValue) {
+            uniqueQueueFamilies.insert(indices.transferFamily);
+        }
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -157,13 +181,35 @@ namespace vulkan {
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        // Multi-draw lets every model go out in one indirect call; without firstInstance only one model can be drawn.
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
         VkPhysicalDeviceFeatures deviceFeatures{};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
-
-        VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
-        indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
-        indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
-        indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+        enabledFeatures = deviceFeatures;
+
+        // The 1.2 features go in one struct, which may not be chained alongside the per-extension ones.
+        VkPhysicalDeviceVulkan12Features supported12{};
+        supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceFeatures2 supportedFeatures2{};
+        supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supportedFeatures2.pNext = &supported12;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures2);
+
+        VkPhysicalDeviceVulkan12Features vulkan12Features{};
+        vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+        vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+        vulkan12Features.descriptorBindingVariableDescriptorCount = VK_TRUE;
+        vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        // Required: frames and uploads are synchronized through one timeline per queue.
+        vulkan12Features.timelineSemaphore = VK_TRUE;
+        // Optional: sorted sprites with several models draw one command per run of equal mesh, counted on the GPU.
+        vulkan12Features.drawIndirectCount = supported12.drawIndirectCount;
+        drawIndirectCount = supported12.drawIndirectCount == VK_TRUE;
 
         VkDeviceCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -171,14 +217,22 @@ namespace vulkan {
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pEnabledFeatures = &deviceFeatures;
 
-        // Update device extensions to include VK_EXT_descriptor_indexing
-        std::vector<const char*> updatedDeviceExtensions = {
-            VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-            VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME
-        };
+        std::vector<const char*> updatedDeviceExtensions = getRequiredDeviceExtensions();
+
+        // Optional: lets the pipeline cache tell hits from misses.
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+        for (const auto& extension : availableExtensions) {
+            if (strcmp(extension.extensionName, VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME) == 0) {
+                updatedDeviceExtensions.push_back(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+                pipelineCreationFeedback = true;
+            }
+        }
         createInfo.enabledExtensionCount = static_cast<uint32_t>(updatedDeviceExtensions.size());
         createInfo.ppEnabledExtensionNames = updatedDeviceExtensions.data();
-        createInfo.pNext = &indexingFeatures;
+        createInfo.pNext = &vulkan12Features;
 
         if (enableValidationLayers) {
             createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -194,6 +248,16 @@ namespace vulkan {
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+        graphicsFamilyIndex = indices.graphicsFamily;
+        transferFamilyIndex = indices.transferFamilyHasValue ? indices.transferFamily : indices.graphicsFamily;
+        vkGetDeviceQueue(device_, transferFamilyIndex, 0, &transferQueue_);
+        graphicsTimeline_ = std::make_unique<QueueTimeline>(device_, graphicsQueue_);
+        if (transferQueue_ != graphicsQueue_) {
+            transferTimeline_ = std::make_unique<QueueTimeline>(device_, transferQueue_);
+        }
+        std::cout << "Transfer queue family: " << transferFamilyIndex
+            << (indices.transferFamilyHasValue ? " (dedicated)" : " (shared with graphics)") << std::endl;
     }
 
     void Device::createCommandPool() {
@@ -207,19 +271,32 @@ namespace vulkan {
         if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
             throw std::runtime_error("failed to create command pool!");
         }
+
+        transferCommandPool = commandPool;
+        if (transferFamilyIndex != graphicsFamilyIndex) {
+            poolInfo.queueFamilyIndex = transferFamilyIndex;
+            if (vkCreateCommandPool(device_, &poolInfo, nullptr, &transferCommandPool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create transfer command pool!");
+            }
+        }
     }
 
     bool Device::isDeviceSuitable(VkPhysicalDevice device) {
         QueueFamilyIndices indices = findQueueFamilies(device);
         bool extensionsSupported = checkDeviceExtensionSupport(device);
-        bool swapChainAdequate = false;
-        if (extensionsSupported) {
+        bool swapChainAdequate = isHeadless();
+        if (extensionsSupported && !isHeadless()) {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
         }
-        VkPhysicalDeviceFeatures supportedFeatures;
-        vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
-        return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+        VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+        timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        VkPhysicalDeviceFeatures2 supportedFeatures{};
+        supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supportedFeatures.pNext = &timelineFeatures;
+        vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
+        return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.features.samplerAnisotropy &&
+            timelineFeatures.timelineSemaphore;
     }
 
     bool Device::checkValidationLayerSupport() {
@@ -250,9 +327,12 @@ namespace vulkan {
     }
 
     std::vector<const char*> Device::getRequiredExtensions() {
-        uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-        std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        std::vector<const char*> extensions;
+        if (!isHeadless()) {
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
         if (enableValidationLayers) {
             extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
         }
@@ -288,11 +368,7 @@ namespace vulkan {
         std::vector<VkExtensionProperties> availableExtensions(extensionCount);
         vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
 
-        // Use updated extensions list
-        std::vector<const char*> updatedDeviceExtensions = {
-            VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-            VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME
-        };
+        std::vector<const char*> updatedDeviceExtensions = getRequiredDeviceExtensions();
         std::set<std::string> requiredExtensions(updatedDeviceExtensions.begin(), updatedDeviceExtensions.end());
 
         for (const auto& extension : availableExtensions) {
@@ -301,6 +377,14 @@ namespace vulkan {
         return requiredExtensions.empty();
     }
 
+    std::vector<const char*> Device::getRequiredDeviceExtensions() const {
+        std::vector<const char*> extensions = { VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME };
+        if (!isHeadless()) {
+            extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+        }
+        return extensions;
+    }
+
     QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device) {
         QueueFamilyIndices indices;
         uint32_t queueFamilyCount = 0;
@@ -314,20 +398,53 @@ namespace vulkan {
                 indices.graphicsFamily = i;
                 indices.graphicsFamilyHasValue = true;
             }
-            VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-            if (queueFamily.queueCount > 0 && presentSupport) {
-                indices.presentFamily = i;
-                indices.presentFamilyHasValue = true;
+            if (isHeadless()) {
+                // Nothing is presented; alias the graphics family so the rest of setup needs no special case.
+                if (indices.graphicsFamilyHasValue) {
+                    indices.presentFamily = indices.graphicsFamily;
+                    indices.presentFamilyHasValue = true;
+                }
+            }
+            else {
+                VkBool32 presentSupport = false;
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+                if (queueFamily.queueCount > 0 && presentSupport) {
+                    indices.presentFamily = i;
+                    indices.presentFamilyHasValue = true;
+                }
             }
             if (indices.isComplete()) break;
             i++;
         }
+
+        // Prefer a pure copy engine; an async-compute family without graphics is the next best thing.
+        int bestScore = 0;
+        for (uint32_t family = 0; family < queueFamilyCount; family++) {
+            VkQueueFlags flags = queueFamilies[family].queueFlags;
+            if (queueFamilies[family].queueCount == 0 || (flags & VK_QUEUE_GRAPHICS_BIT)) {
+                continue;
+            }
+            int score = 0;
+            if (flags & VK_QUEUE_TRANSFER_BIT) {
+                score = (flags & VK_QUEUE_COMPUTE_BIT) ? 1 : 2;
+            }
+            else if (flags & VK_QUEUE_COMPUTE_BIT) {
+                score = 1;
+            }
+            if (score > bestScore) {
+                bestScore = score;
+                indices.transferFamily = family;
+                indices.transferFamilyHasValue = true;
+            }
+        }
         return indices;
     }
 
     SwapChainSupportDetails Device::querySwapChainSupport(VkPhysicalDevice device) {
-        SwapChainSupportDetails details;
+        SwapChainSupportDetails details{};
+        if (isHeadless()) {
+            return details;
+        }
         vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface_, &details.capabilities);
         uint32_t formatCount;
         vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface_, &formatCount, nullptr);
@@ -357,25 +474,12 @@ namespace vulkan {
         throw std::runtime_error("failed to find supported format!");
     }
 
-    uint32_t Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-        VkPhysicalDeviceMemoryProperties memProperties;
-        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-
-        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-            if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-                return i;
-            }
-        }
-
-        throw std::runtime_error("failed to find suitable memory type!");
-    }
-
     void Device::createBuffer(
         VkDeviceSize size,
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer& buffer,
-        VkDeviceMemory& bufferMemory) {
+        MemoryAllocation& bufferMemory) {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferInfo.size = size;
@@ -389,15 +493,15 @@ namespace vulkan {
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate buffer memory!");
+        bufferMemory = allocator->allocate(memRequirements, properties, true);
+        if (vkBindBufferMemory(device_, buffer, bufferMemory.memory, bufferMemory.offset) != VK_SUCCESS) {
+            throw std::runtime_error("failed to bind buffer memory!");
         }
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+    }
+
+    void Device::destroyBuffer(VkBuffer buffer, MemoryAllocation& bufferMemory) {
+        vkDestroyBuffer(device_, buffer, nullptr);
+        allocator->free(bufferMemory);
     }
 
     VkCommandBuffer Device::beginSingleTimeCommands() {
@@ -421,13 +525,8 @@ namespace vulkan {
     void Device::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
         vkEndCommandBuffer(commandBuffer);
 
-        VkSubmitInfo submitInfo{};
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &commandBuffer;
-
-        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(graphicsQueue_);
+        // Waits for this submit only, not for frames still in flight on the same queue.
+        graphicsTimeline_->wait(graphicsTimeline_->submit(&commandBuffer, 1));
 
         vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
     }
@@ -462,7 +561,7 @@ namespace vulkan {
         const VkImageCreateInfo& imageInfo,
         VkMemoryPropertyFlags properties,
         VkImage& image,
-        VkDeviceMemory& imageMemory) {
+        MemoryAllocation& imageMemory) {
         if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
             throw std::runtime_error("failed to create image!");
         }
@@ -470,20 +569,17 @@ namespace vulkan {
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
-
-        if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+        imageMemory = allocator->allocate(memRequirements, properties, imageInfo.tiling == VK_IMAGE_TILING_LINEAR);
+        if (vkBindImageMemory(device_, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS) {
             throw std::runtime_error("failed to bind image memory!");
         }
     }
 
+    void Device::destroyImage(VkImage image, MemoryAllocation& imageMemory) {
+        vkDestroyImage(device_, image, nullptr);
+        allocator->free(imageMemory);
+    }
+
     void Device::populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo) {
         createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
@@ -499,4 +595,11 @@ namespace vulkan {
     VkDevice Device::getDevice() {
         return device_;
     }
+
+    MeshPool& Device::getMeshPool() {
+        if (!meshPool) {
+            meshPool = std::make_unique<MeshPool>(*this, static_cast<uint32_t>(sizeof(Model::Vertex)));
+        }
+        return *meshPool;
+    }
 }
\ No newline at end of file
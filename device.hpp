@@ -1,5 +1,10 @@
 #pragma once
 #include "window.hpp"
+#include "memoryAllocator.hpp"
+#include "pipelineCache.hpp"
+#include "meshPool.hpp"
+#include "queueTimeline.hpp"
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -13,8 +18,10 @@ namespace vulkan {
     struct QueueFamilyIndices {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        uint32_t transferFamily;
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
+        bool transferFamilyHasValue = false; // only set for a family without graphics support
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
     };
 
@@ -38,11 +45,34 @@ namespace vulkan {
         VkCommandPool getCommandPool() { return commandPool; }
         VkDevice device() { return device_; }
         VkSurfaceKHR surface() { return surface_; }
+        // Headless devices have no surface or swapchain extension; the present queue aliases the graphics queue.
+        bool isHeadless() const { return window.isHeadless(); }
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
 
+        // Falls back to the graphics queue and pool when the GPU has no separate transfer family.
+        VkQueue transferQueue() { return transferQueue_; }
+        VkCommandPool getTransferCommandPool() { return transferCommandPool; }
+        bool hasDedicatedTransferQueue() const { return transferQueue_ != graphicsQueue_; }
+        // Every graphics-queue submit signals the graphics timeline; the transfer timeline is the same one without a
+        // dedicated copy queue. Frames, uploads and compute all wait on values of these instead of fences.
+        QueueTimeline& graphicsTimeline() { return *graphicsTimeline_; }
+        QueueTimeline& transferTimeline() { return transferTimeline_ ? *transferTimeline_ : *graphicsTimeline_; }
+        uint32_t graphicsQueueFamily() const { return graphicsFamilyIndex; }
+        uint32_t transferQueueFamily() const { return transferFamilyIndex; }
+
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
-        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) { return allocator->findMemoryType(typeFilter, properties); }
+        MemoryAllocator& getAllocator() { return *allocator; }
+        PipelineCache& getPipelineCache() { return *pipelineCache; }
+        // Shared vertex and index storage for every Model; created on first use.
+        MeshPool& getMeshPool();
+        // The pool if it exists, without creating one; null before the first Model and once the device is torn down.
+        MeshPool* findMeshPool() { return meshPool.get(); }
+        // Core features actually enabled; multiDrawIndirect and drawIndirectFirstInstance are turned on when supported.
+        const VkPhysicalDeviceFeatures& getEnabledFeatures() const { return enabledFeatures; }
+        // Whether the 1.2 drawIndirectCount feature is enabled, which vkCmdDrawIndexedIndirectCount needs.
+        bool hasDrawIndirectCount() const { return drawIndirectCount; }
         QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
         VkFormat findSupportedFormat(
             const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
@@ -53,7 +83,8 @@ namespace vulkan {
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer& buffer,
-            VkDeviceMemory& bufferMemory);
+            MemoryAllocation& bufferMemory);
+        void destroyBuffer(VkBuffer buffer, MemoryAllocation& bufferMemory);
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -64,7 +95,8 @@ namespace vulkan {
             const VkImageCreateInfo& imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage& image,
-            VkDeviceMemory& imageMemory);
+            MemoryAllocation& imageMemory);
+        void destroyImage(VkImage image, MemoryAllocation& imageMemory);
 
         VkPhysicalDeviceProperties properties;
         VkQueue getGraphicsQueue() { return graphicsQueue_; }
@@ -89,6 +121,7 @@ namespace vulkan {
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
         void hasGflwRequiredInstanceExtensions();
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        std::vector<const char*> getRequiredDeviceExtensions() const;
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
         VkInstance instance;
@@ -96,11 +129,23 @@ namespace vulkan {
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
         Window& window;
         VkCommandPool commandPool;
+        VkCommandPool transferCommandPool;
+        uint32_t graphicsFamilyIndex;
+        uint32_t transferFamilyIndex;
 
         VkDevice device_;
-        VkSurfaceKHR surface_;
+        VkSurfaceKHR surface_ = VK_NULL_HANDLE;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_;
+        std::unique_ptr<MemoryAllocator> allocator;
+        std::unique_ptr<PipelineCache> pipelineCache;
+        std::unique_ptr<MeshPool> meshPool;
+        std::unique_ptr<QueueTimeline> graphicsTimeline_;
+        std::unique_ptr<QueueTimeline> transferTimeline_; // only with a dedicated transfer queue
+        VkPhysicalDeviceFeatures enabledFeatures{};
+        bool pipelineCreationFeedback = false;
+        bool drawIndirectCount = false;
 
         const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
         const std::vector<const char*> deviceExtensions = {
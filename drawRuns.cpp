@@ -0,0 +1,150 @@
+#include "drawRuns.hpp"
+#include <array>
+#include <iostream>
+#include <stdexcept>
+
+namespace vulkan {
+    static void runsBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+        VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    static void computeBarrier(VkCommandBuffer commandBuffer) {
+        runsBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    }
+
+    DrawRuns::DrawRuns(Device& device, VkBuffer keys, VkBuffer meshDraws, uint32_t capacity)
+        : device{ device }, capacity{ capacity } {
+        if (!device.hasDrawIndirectCount()) {
+            throw std::runtime_error("drawing sorted sprites with several models requires drawIndirectCount!");
+        }
+        if (!device.getEnabledFeatures().multiDrawIndirect || capacity > device.properties.limits.maxDrawIndirectCount) {
+            throw std::runtime_error("drawing sorted sprites with several models requires a multi-draw of one command per sprite!");
+        }
+        uint32_t blockCount = (capacity + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        if (blockCount > device.properties.limits.maxComputeWorkGroupCount[0]) {
+            throw std::runtime_error("draw run capacity exceeds the compute workgroup limit!");
+        }
+
+        // Every sprite can start its own run in the worst case.
+        runs = std::make_unique<Buffer>(device, sizeof(VkDrawIndexedIndirectCommand), capacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        // The run total the scan writes, which is the draw count, followed by one entry per block.
+        runCounts = std::make_unique<Buffer>(device, sizeof(uint32_t), blockCount + 1,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        createDescriptorSet(keys, meshDraws);
+        countPipeline = std::make_unique<ComputePipeline>(device, "drawRunCount.comp.spv", descriptorSetLayout, sizeof(DrawRunPush));
+        scanPipeline = std::make_unique<ComputePipeline>(device, "drawRunScan.comp.spv", descriptorSetLayout, sizeof(DrawRunPush));
+        emitPipeline = std::make_unique<ComputePipeline>(device, "drawRunEmit.comp.spv", descriptorSetLayout, sizeof(DrawRunPush));
+        sizePipeline = std::make_unique<ComputePipeline>(device, "drawRunSize.comp.spv", descriptorSetLayout, sizeof(DrawRunPush));
+        std::cout << "Draw runs created for " << capacity << " sprites in " << blockCount << " blocks" << std::endl;
+    }
+
+    DrawRuns::~DrawRuns() {
+        vkDestroyDescriptorPool(device.device(), descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(device.device(), descriptorSetLayout, nullptr);
+    }
+
+    void DrawRuns::createDescriptorSet(VkBuffer keys, VkBuffer meshDraws) {
+        // 0: sorted keys; 1: per-mesh commands; 2: run commands; 3: run counts.
+        VkDescriptorSetLayoutBinding bindings[4] = {};
+        for (uint32_t binding = 0; binding < 4; binding++) {
+            bindings[binding].binding = binding;
+            bindings[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[binding].descriptorCount = 1;
+            bindings[binding].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = 4;
+        layoutInfo.pBindings = bindings;
+        if (vkCreateDescriptorSetLayout(device.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create draw run descriptor set layout!");
+        }
+
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSize.descriptorCount = 4;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        poolInfo.maxSets = 1;
+        if (vkCreateDescriptorPool(device.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create draw run descriptor pool!");
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &descriptorSetLayout;
+        if (vkAllocateDescriptorSets(device.device(), &allocInfo, &descriptorSet) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate draw run descriptor set!");
+        }
+
+        VkBuffer buffers[4] = { keys, meshDraws, runs->getBuffer(), runCounts->getBuffer() };
+        std::array<VkDescriptorBufferInfo, 4> bufferInfos{};
+        std::array<VkWriteDescriptorSet, 4> writes{};
+        for (uint32_t binding = 0; binding < 4; binding++) {
+            bufferInfos[binding].buffer = buffers[binding];
+            bufferInfos[binding].offset = 0;
+            bufferInfos[binding].range = VK_WHOLE_SIZE;
+
+            writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[binding].dstSet = descriptorSet;
+            writes[binding].dstBinding = binding;
+            writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[binding].descriptorCount = 1;
+            writes[binding].pBufferInfo = &bufferInfos[binding];
+        }
+        vkUpdateDescriptorSets(device.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    void DrawRuns::record(VkCommandBuffer commandBuffer, uint32_t count, uint32_t meshBits) {
+        if (count > capacity) {
+            throw std::runtime_error("draw run count exceeds its capacity!");
+        }
+
+        DrawRunPush push{};
+        push.count = count;
+        push.blockCount = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        push.meshBits = meshBits;
+
+        // The previous frame's draw must be done reading the commands and the draw count before they are rebuilt.
+        runsBarrier(commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+        // With no blocks the scan still runs, so the draw count comes out zero.
+        std::array<ComputePipeline*, 4> passes = { countPipeline.get(), scanPipeline.get(), emitPipeline.get(), sizePipeline.get() };
+        std::array<uint32_t, 4> invocations = { push.blockCount * BLOCK_SIZE, ComputePipeline::WORKGROUP_SIZE, push.blockCount * BLOCK_SIZE, count };
+        for (size_t pass = 0; pass < passes.size(); pass++) {
+            if (invocations[pass] == 0) {
+                continue;
+            }
+            passes[pass]->bind(commandBuffer);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, passes[pass]->getPipelineLayout(), 0, 1, &descriptorSet, 0, nullptr);
+            vkCmdPushConstants(commandBuffer, passes[pass]->getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DrawRunPush), &push);
+            passes[pass]->dispatch(commandBuffer, invocations[pass]);
+            if (pass + 1 < passes.size()) {
+                computeBarrier(commandBuffer);
+            }
+        }
+
+        runsBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+    }
+
+    void DrawRuns::draw(VkCommandBuffer commandBuffer) {
+        vkCmdDrawIndexedIndirectCount(commandBuffer, runs->getBuffer(), 0, runCounts->getBuffer(), 0, capacity,
+            sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
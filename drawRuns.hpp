@@ -0,0 +1,52 @@
+#pragma once
+#include "buffer.hpp"
+#include "computePipeline.hpp"
+#include "device.hpp"
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+
+namespace vulkan {
+    struct DrawRunPush {
+        uint32_t count;
+        uint32_t blockCount;
+        uint32_t meshBits;
+    };
+
+    // Turns a sorted visible list into one indexed draw per run of sprites that share a mesh, so sprites of several
+    // models interleave in key order. A run-start count per block, a scan of those counts, then an emit pass that
+    // writes each run's command; the scan total is the draw count read by vkCmdDrawIndexedIndirectCount.
+    class DrawRuns {
+    public:
+        static constexpr uint32_t BLOCK_SIZE = 256; // keys per workgroup, one per invocation
+
+        // keys are the sorted keys from cull.comp's visibleKey; meshDraws holds one DrawCommand per mesh, whose
+        // indexCount, firstIndex and vertexOffset are copied into each run of that mesh.
+        DrawRuns(Device& device, VkBuffer keys, VkBuffer meshDraws, uint32_t capacity);
+        ~DrawRuns();
+
+        DrawRuns(const DrawRuns&) = delete;
+        DrawRuns& operator=(const DrawRuns&) = delete;
+
+        // Builds the commands for the first count keys. The caller makes its writes to keys and meshDraws visible
+        // to compute first; the runs are visible to indirect reads afterwards.
+        void record(VkCommandBuffer commandBuffer, uint32_t count, uint32_t meshBits);
+        // Draws the runs built by the last record; gl_InstanceIndex is the sprite's position in the sorted list.
+        void draw(VkCommandBuffer commandBuffer);
+
+    private:
+        void createDescriptorSet(VkBuffer keys, VkBuffer meshDraws);
+
+        Device& device;
+        uint32_t capacity;
+        std::unique_ptr<Buffer> runs;
+        std::unique_ptr<Buffer> runCounts;
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        std::unique_ptr<ComputePipeline> countPipeline;
+        std::unique_ptr<ComputePipeline> scanPipeline;
+        std::unique_ptr<ComputePipeline> emitPipeline;
+        std::unique_ptr<ComputePipeline> sizePipeline;
+    };
+}
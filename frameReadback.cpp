@@ -0,0 +1,140 @@
+#include "frameReadback.hpp"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <stdexcept>
+
+namespace vulkan {
+
+    FrameReadback::FrameReadback(Device& device, uint32_t framesInFlight) : device{ device }, slots(framesInFlight) {}
+
+    FrameReadback::~FrameReadback() {
+        for (auto& slot : slots) {
+            if (slot.buffer != VK_NULL_HANDLE) {
+                device.destroyBuffer(slot.buffer, slot.memory);
+            }
+        }
+    }
+
+    bool FrameReadback::isFormatSupported(VkFormat format) {
+        switch (format) {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void FrameReadback::capture(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frameNumber,
+        VkImage image, VkImageLayout layout, VkFormat format, VkExtent2D extent) {
+        if (!isFormatSupported(format)) {
+            throw std::runtime_error("frame readback does not support this color format!");
+        }
+
+        // The slot is free: its previous copy was collected when this frame slot's timeline value was waited for.
+        Slot& slot = slots[frameIndex];
+        VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+        if (slot.size < size) {
+            if (slot.buffer != VK_NULL_HANDLE) {
+                device.destroyBuffer(slot.buffer, slot.memory);
+            }
+            device.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, slot.buffer, slot.memory);
+            slot.size = size;
+        }
+
+        VkImageMemoryBarrier toTransfer{};
+        toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        toTransfer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        toTransfer.oldLayout = layout;
+        toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toTransfer.image = image;
+        toTransfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { extent.width, extent.height, 1 };
+        vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+        // Hand the image back in the layout present (or the next frame's render pass) expects.
+        VkImageMemoryBarrier toOriginal = toTransfer;
+        toOriginal.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        toOriginal.dstAccessMask = 0;
+        toOriginal.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        toOriginal.newLayout = layout;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &toOriginal);
+
+        VkBufferMemoryBarrier toHost{};
+        toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toHost.buffer = slot.buffer;
+        toHost.offset = 0;
+        toHost.size = size;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+            0, 0, nullptr, 1, &toHost, 0, nullptr);
+
+        slot.pending = true;
+        slot.swizzle = format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+        slot.frameNumber = frameNumber;
+        slot.extent = extent;
+    }
+
+    void FrameReadback::collect(uint32_t frameIndex) {
+        Slot& slot = slots[frameIndex];
+        if (!slot.pending) {
+            return;
+        }
+        slot.pending = false;
+
+        CapturedFrame frame{};
+        frame.frameNumber = slot.frameNumber;
+        frame.width = slot.extent.width;
+        frame.height = slot.extent.height;
+        frame.rgba.resize(static_cast<size_t>(frame.width) * frame.height * 4);
+        memcpy(frame.rgba.data(), slot.memory.mapped, frame.rgba.size());
+        if (slot.swizzle) {
+            for (size_t i = 0; i < frame.rgba.size(); i += 4) {
+                std::swap(frame.rgba[i], frame.rgba[i + 2]);
+            }
+        }
+        frames.push_back(std::move(frame));
+    }
+
+    void FrameReadback::collectAll() {
+        for (uint32_t i = 0; i < slots.size(); i++) {
+            collect(i);
+        }
+        std::sort(frames.begin(), frames.end(), [](const CapturedFrame& a, const CapturedFrame& b) { return a.frameNumber < b.frameNumber; });
+    }
+
+    std::vector<CapturedFrame> FrameReadback::takeFrames() {
+        std::vector<CapturedFrame> taken = std::move(frames);
+        frames.clear();
+        return taken;
+    }
+
+    bool FrameReadback::hasPending() const {
+        for (const auto& slot : slots) {
+            if (slot.pending) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "device.hpp"
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+
+namespace vulkan {
+
+    struct CapturedFrame {
+        uint64_t frameNumber = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> rgba; // tightly packed rows, top row first
+    };
+
+    // Copies a finished color attachment into a persistently mapped host buffer, one per frame in flight.
+    // The copy rides in the frame's own command buffer and is guarded by the frame's timeline value, so nothing waits:
+    // collect() is called once that value is reached and turns the copy into a CapturedFrame.
+    class FrameReadback {
+    public:
+        FrameReadback(Device& device, uint32_t framesInFlight);
+        ~FrameReadback();
+
+        FrameReadback(const FrameReadback&) = delete;
+        FrameReadback& operator=(const FrameReadback&) = delete;
+
+        static bool isFormatSupported(VkFormat format);
+
+        // Records the copy after the render pass. image must be in layout and is returned to it afterwards.
+        void capture(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frameNumber,
+            VkImage image, VkImageLayout layout, VkFormat format, VkExtent2D extent);
+        // Call only once frameIndex's last submission has reached its timeline value.
+        void collect(uint32_t frameIndex);
+        // Collects every slot; the caller must have waited for the device to go idle.
+        void collectAll();
+
+        std::vector<CapturedFrame> takeFrames();
+        bool hasPending() const;
+
+    private:
+        struct Slot {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            MemoryAllocation memory{};
+            VkDeviceSize size = 0;
+            bool pending = false;
+            bool swizzle = false; // BGRA source
+            uint64_t frameNumber = 0;
+            VkExtent2D extent{};
+        };
+
+        Device& device;
+        std::vector<Slot> slots;
+        std::vector<CapturedFrame> frames;
+    };
+}
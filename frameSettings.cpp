@@ -0,0 +1,42 @@
+#include "frameSettings.hpp"
+#include "swapChain.hpp"
+#include <stdexcept>
+#include <string>
+
+namespace vulkan {
+    FrameSettings FrameSettings::parse(int argc, char* argv[]) {
+        FrameSettings settings;
+        for (int i = 0; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--frames-in-flight" && hasValue) {
+                // Rejected here so a bad flag fails before any window or device is created.
+                unsigned long frames = std::stoul(argv[++i]);
+                if (frames < 1 || frames > SwapChain::MAX_FRAMES_IN_FLIGHT) {
+                    throw std::runtime_error("--frames-in-flight must be between 1 and " + std::to_string(SwapChain::MAX_FRAMES_IN_FLIGHT)
+                        + ", got " + argv[i]);
+                }
+                settings.framesInFlight = static_cast<uint32_t>(frames);
+            }
+            else if (arg == "--present" && hasValue) {
+                std::string policy = argv[++i];
+                if (policy == "low-latency") {
+                    settings.presentPolicy = PresentPolicy::LowLatency;
+                }
+                else if (policy == "vsync") {
+                    settings.presentPolicy = PresentPolicy::Vsync;
+                }
+                else if (policy == "relaxed") {
+                    settings.presentPolicy = PresentPolicy::Relaxed;
+                }
+                else {
+                    throw std::runtime_error("unknown present policy: " + policy);
+                }
+            }
+            else if (arg == "--fps-limit" && hasValue) {
+                settings.frameRateLimit = std::stof(argv[++i]);
+            }
+        }
+        return settings;
+    }
+}
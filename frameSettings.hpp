@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+namespace vulkan {
+    enum class PresentPolicy {
+        LowLatency, // MAILBOX, else IMMEDIATE (tears), else FIFO
+        Vsync,      // FIFO, which every device supports
+        Relaxed     // FIFO_RELAXED: vsync, but a late frame is shown at once instead of waiting a whole refresh
+    };
+
+    // Latency and throughput trade-offs, picked per deployment at startup rather than at build time.
+    struct FrameSettings {
+        uint32_t framesInFlight = 2; // 1 to SwapChain::MAX_FRAMES_IN_FLIGHT; fewer means less queued latency
+        PresentPolicy presentPolicy = PresentPolicy::LowLatency;
+        float frameRateLimit = 0.0f; // frames per second, 0 for unlimited
+
+        // Reads --frames-in-flight N  --present low-latency|vsync|relaxed  --fps-limit N and ignores anything else.
+        static FrameSettings parse(int argc, char* argv[]);
+    };
+}
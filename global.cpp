@@ -1,7 +1,9 @@
-#include "sprite.hpp"
-#include <vector>
+#include "spriteStore.hpp"
 #include "global.hpp"
 
 namespace vulkan {
-    std::vector<Sprite> sprites;
+    SpriteStore sprites;
+    TextureRegistry textureRegistry;
+    ShaderArchive shaderArchive{ "shaders.pak" };
+    FrameSettings frameSettings;
 }
\ No newline at end of file
@@ -1,9 +1,17 @@
 #pragma once
 #include <glm/glm.hpp>
+#include "spriteStore.hpp"
+#include "textureRegistry.hpp"
+#include "shaderArchive.hpp"
+#include "frameSettings.hpp"
 
 namespace vulkan {
     struct Push {
         glm::mat4 projection;
     };
-    extern std::vector<Sprite> sprites;
+    extern SpriteStore sprites;
+    extern TextureRegistry textureRegistry;
+    extern ShaderArchive shaderArchive;
+    // Parsed from the command line at startup; every Renderer created afterwards uses it unless given its own.
+    extern FrameSettings frameSettings;
 }
\ No newline at end of file
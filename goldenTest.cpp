@@ -0,0 +1,203 @@
+#include "goldenTest.hpp"
+#include "global.hpp"
+#include "main.hpp"
+#include "pipeline.hpp"
+#include "pngImage.hpp"
+#include "renderer.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <iostream>
+
+namespace vulkan {
+    GoldenOptions GoldenTest::parseOptions(int argc, char* argv[]) {
+        GoldenOptions options;
+        for (int i = 0; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--dir" && hasValue) {
+                options.directory = argv[++i];
+            }
+            else if (arg == "--update-golden") {
+                options.update = true;
+            }
+            else if (arg == "--tolerance" && hasValue) {
+                options.channelTolerance = std::stoi(argv[++i]);
+            }
+            else if (arg == "--max-mismatch" && hasValue) {
+                options.maxMismatchFraction = std::stod(argv[++i]);
+            }
+            else if (arg == "--sprites" && hasValue) {
+                options.spriteCount = static_cast<size_t>(std::stoull(argv[++i]));
+            }
+            else if (arg == "--frames" && hasValue) {
+                options.frames = static_cast<uint32_t>(std::stoul(argv[++i]));
+            }
+        }
+        return options;
+    }
+
+    bool GoldenTest::run() {
+        Window window{ static_cast<int>(options.width), static_cast<int>(options.height), "Golden", true };
+        Device device{ window };
+
+        // The CPU scenes pack with whichever kernel this machine picks, so every kernel must match the scalar one first.
+        bool passed = true;
+        for (const SpriteKernelCheck& check : compareSpriteKernels(10007)) {
+            if (check.supported && !check.matchesScalar) {
+                std::cerr << "sprite kernel " << spriteKernelName(check.kernel) << " differs from the scalar kernel" << std::endl;
+                passed = false;
+            }
+        }
+
+        const GoldenScene scenes[] = {
+            { "sprites_cpu", SpriteMotion::Cpu, SpriteFormat::Full, SpriteGeometry::Model },
+            { "sprites_gpu", SpriteMotion::Gpu, SpriteFormat::Full, SpriteGeometry::Model },
+            { "sprites_compact", SpriteMotion::Cpu, SpriteFormat::Compact, SpriteGeometry::Model },
+            { "sprites_pulled", SpriteMotion::Gpu, SpriteFormat::Full, SpriteGeometry::VertexPulling },
+            { "sprites_models", SpriteMotion::Gpu, SpriteFormat::Full, SpriteGeometry::Model, 3 },
+            { "sprites_sorted", SpriteMotion::Gpu, SpriteFormat::Full, SpriteGeometry::VertexPulling, 1, SpriteOrder::Sorted },
+            { "sprites_sorted_models", SpriteMotion::Gpu, SpriteFormat::Full, SpriteGeometry::Model, 3, SpriteOrder::Sorted },
+            { "sprites_removed", SpriteMotion::Gpu, SpriteFormat::Full, SpriteGeometry::Model, 1, SpriteOrder::Unsorted, true },
+        };
+        size_t compared = 0;
+        for (const GoldenScene& scene : scenes) {
+            // Without a stored reference there is nothing to catch a regression against, so the scene does not count yet.
+            if (!options.update && !std::filesystem::exists(goldenPath(scene.name))) {
+                std::cout << scene.name << ": no reference at " << goldenPath(scene.name)
+                    << ", skipped (run with --update-golden and commit the image)" << std::endl;
+                continue;
+            }
+            passed = runScene(window, device, scene) && passed;
+            compared++;
+        }
+        if (compared == 0) {
+            std::cerr << "no golden references found in " << options.directory << std::endl;
+            passed = false;
+        }
+        std::cout << (passed ? "Golden images: all passed" : "Golden images: FAILED") << std::endl;
+        return passed;
+    }
+
+    std::string GoldenTest::goldenPath(const std::string& name) const {
+        return (std::filesystem::path(options.directory) / (name + ".png")).string();
+    }
+
+    bool GoldenTest::runScene(Window& window, Device& device, const GoldenScene& scene) {
+        std::vector<CapturedFrame> captures;
+        {
+            Renderer renderer{ window, device };
+            Pipeline assets{ device, "triangle.vert.spv", "triangle.frag.spv", renderer.getSwapChainRenderPass() };
+
+            seedRandom(options.seed);
+            assets.loadSprites(options.spriteCount, scene.modelCount);
+            if (scene.order == SpriteOrder::Sorted) {
+                // A fixed spread of layers and depths, so the image only matches if the sort really reorders.
+                // Models are dealt out round-robin, so the layer steps past them and each layer mixes every model.
+                for (size_t i = 0; i < sprites.size(); i++) {
+                    sprites.layers()[i] = static_cast<uint32_t>(i / scene.modelCount % 3);
+                    sprites.depths()[i] = static_cast<float>(i * 37 % 101) / 100.0f;
+                    sprites.colors()[i] = glm::vec3(0.4f + 0.3f * sprites.layers()[i], sprites.depths()[i], 1.0f - sprites.depths()[i]);
+                }
+            }
+            RenderSystem renderSystem{ device, window, renderer.getSwapChainRenderPass(), assets.getDescriptorSetLayout(),
+                renderer.getFramesInFlight(), scene.format, scene.geometry, scene.order };
+            renderSystem.setSpriteMotion(scene.motion);
+            renderSystem.setDeterministicUpdates(true);
+            renderSystem.initialize();
+
+            const float deltaTime = 1.0f / 60.0f;
+            for (uint32_t frame = 0; frame < options.frames; frame++) {
+                VkCommandBuffer commandBuffer = renderer.beginFrame();
+                if (!commandBuffer) {
+                    throw std::runtime_error("headless frame could not be started!");
+                }
+                if (frame + 1 == options.frames) {
+                    renderer.requestCapture();
+                }
+                if (scene.removeMidway && frame == options.frames / 2) {
+                    // Every third sprite, so the tail is swapped into holes (some twice) after the GPU has moved it.
+                    std::vector<SpriteHandle> removed;
+                    for (size_t i = 0; i < sprites.size(); i += 3) {
+                        removed.push_back(sprites.handleAt(i));
+                    }
+                    for (SpriteHandle handle : removed) {
+                        sprites.remove(handle);
+                    }
+                }
+                renderSystem.updateSprites(commandBuffer, renderer.getFrameIndex(), deltaTime);
+                renderer.beginSwapChainRenderPass(commandBuffer);
+                renderSystem.renderSprites(commandBuffer);
+                renderer.endSwapChainRenderPass(commandBuffer);
+                renderer.endFrame();
+            }
+
+            renderer.flushCaptures();
+            captures = renderer.takeCapturedFrames();
+            sprites.clear();
+        }
+
+        if (captures.empty()) {
+            std::cerr << scene.name << ": no frame was captured" << std::endl;
+            return false;
+        }
+        return compare(captures.back(), scene.name);
+    }
+
+    bool GoldenTest::compare(const CapturedFrame& frame, const std::string& name) const {
+        std::filesystem::path base = std::filesystem::path(options.directory) / name;
+        std::string path = goldenPath(name);
+
+        if (options.update) {
+            std::filesystem::create_directories(options.directory);
+            if (!writePng(path, frame.width, frame.height, frame.rgba)) {
+                std::cerr << name << ": failed to write " << path << std::endl;
+                return false;
+            }
+            std::cout << name << ": golden updated at " << path << std::endl;
+            return true;
+        }
+
+        uint32_t width, height;
+        std::vector<uint8_t> golden;
+        if (!readPng(path, width, height, golden)) {
+            std::cerr << name << ": missing golden " << path << " (run with --update-golden to create it)" << std::endl;
+            return false;
+        }
+        if (width != frame.width || height != frame.height) {
+            std::cerr << name << ": golden is " << width << "x" << height << ", frame is " << frame.width << "x" << frame.height << std::endl;
+            return false;
+        }
+
+        // Mismatched pixels are painted red on a dimmed copy of the frame so the regression is easy to spot.
+        std::vector<uint8_t> diff(frame.rgba.size());
+        size_t mismatched = 0;
+        int worst = 0;
+        for (size_t pixel = 0; pixel < frame.rgba.size(); pixel += 4) {
+            int difference = 0;
+            for (size_t channel = 0; channel < 4; channel++) {
+                difference = std::max(difference, std::abs(frame.rgba[pixel + channel] - golden[pixel + channel]));
+            }
+            worst = std::max(worst, difference);
+            bool mismatch = difference > options.channelTolerance;
+            mismatched += mismatch ? 1 : 0;
+            for (size_t channel = 0; channel < 3; channel++) {
+                diff[pixel + channel] = mismatch ? (channel == 0 ? 255 : 0) : frame.rgba[pixel + channel] / 4;
+            }
+            diff[pixel + 3] = 255;
+        }
+
+        size_t pixelCount = static_cast<size_t>(width) * height;
+        double mismatchFraction = static_cast<double>(mismatched) / pixelCount;
+        bool passed = mismatchFraction <= options.maxMismatchFraction;
+        std::cout << name << ": " << mismatched << " of " << pixelCount << " pixels differ by more than "
+            << options.channelTolerance << " (worst " << worst << ") - " << (passed ? "pass" : "FAIL") << std::endl;
+
+        if (!passed) {
+            writePng(base.string() + ".actual.png", frame.width, frame.height, frame.rgba);
+            writePng(base.string() + ".diff.png", frame.width, frame.height, diff);
+        }
+        return passed;
+    }
+}
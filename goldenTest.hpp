@@ -0,0 +1,53 @@
+#pragma once
+#include "device.hpp"
+#include "frameReadback.hpp"
+#include "renderSystem.hpp"
+#include "window.hpp"
+#include <cstdint>
+#include <string>
+
+namespace vulkan {
+    struct GoldenOptions {
+        std::string directory = "golden";
+        bool update = false;           // rewrite the stored images instead of comparing
+        uint32_t width = 256;
+        uint32_t height = 256;
+        size_t spriteCount = 256;
+        uint32_t frames = 30;
+        uint32_t seed = 123456789;
+        int channelTolerance = 2;      // per-channel difference still counted as equal
+        double maxMismatchFraction = 0.001;
+    };
+
+    struct GoldenScene {
+        const char* name;
+        SpriteMotion motion;
+        SpriteFormat format;
+        SpriteGeometry geometry;
+        uint32_t modelCount = 1;
+        SpriteOrder order = SpriteOrder::Unsorted;
+        bool removeMidway = false; // removes every third sprite halfway through the run
+    };
+
+    // Renders a fixed scene headless with each sprite motion path, the compact format, vertex pulling, mixed models, GPU sorting and
+    // removal under GPU motion, reads the last frame back and compares it with <directory>/sprites_<variant>.png. Failures leave
+    // .actual.png and .diff.png beside the golden. Every SIMD sprite kernel must also pack byte-identical to the scalar one.
+    // A scene whose reference has not been committed yet is reported and skipped rather than failed, but a run that
+    // compares no scene at all fails.
+    class GoldenTest {
+    public:
+        explicit GoldenTest(const GoldenOptions& options) : options{ options } {}
+
+        // Parses --dir path  --update-golden  --tolerance N  --max-mismatch F  --sprites N  --frames N.
+        static GoldenOptions parseOptions(int argc, char* argv[]);
+
+        bool run();
+
+    private:
+        bool runScene(Window& window, Device& device, const GoldenScene& scene);
+        std::string goldenPath(const std::string& name) const;
+        bool compare(const CapturedFrame& frame, const std::string& name) const;
+
+        GoldenOptions options;
+    };
+}
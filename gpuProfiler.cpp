@@ -0,0 +1,197 @@
+#include "gpuProfiler.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <stdexcept>
+#include <iostream>
+
+namespace vulkan {
+
+    GpuProfiler::GpuProfiler(Device& device, uint32_t framesInFlight) : device{ device } {
+        uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device.findPhysicalDevice(), &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device.findPhysicalDevice(), &familyCount, families.data());
+
+        uint32_t validBits = families[device.graphicsQueueFamily()].timestampValidBits;
+        if (validBits == 0) {
+            std::cout << "GPU profiler disabled: graphics queue does not support timestamps" << std::endl;
+            return;
+        }
+        supported = true;
+        timestampPeriod = device.properties.limits.timestampPeriod;
+        timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+        frames.resize(framesInFlight);
+        for (auto& frame : frames) {
+            VkQueryPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            poolInfo.queryCount = MAX_SCOPES * 2;
+            if (vkCreateQueryPool(device.device(), &poolInfo, nullptr, &frame.pool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create timestamp query pool!");
+            }
+        }
+    }
+
+    GpuProfiler::~GpuProfiler() {
+        for (auto& frame : frames) {
+            vkDestroyQueryPool(device.device(), frame.pool, nullptr);
+        }
+    }
+
+    void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex) {
+        currentFrame = nullptr;
+        openScopes.clear();
+        if (!supported) {
+            return;
+        }
+
+        FrameQueries& frame = frames[frameIndex % frames.size()];
+        collect(frame);
+        if (!enabled) {
+            return;
+        }
+
+        vkCmdResetQueryPool(commandBuffer, frame.pool, 0, MAX_SCOPES * 2);
+        frame.frameNumber = ++frameCount;
+        currentFrame = &frame;
+    }
+
+    void GpuProfiler::collect(FrameQueries& frame) {
+        if (frame.queryCount == 0) {
+            return;
+        }
+        if (frame.frameNumber < firstCountedFrame) {
+            frame.scopes.clear();
+            frame.queryCount = 0;
+            return;
+        }
+
+        // Each query comes back as { timestamp, availability }; without WAIT_BIT an unfinished query reports availability 0.
+        std::vector<uint64_t> results(frame.queryCount * 2);
+        VkResult result = vkGetQueryPoolResults(device.device(), frame.pool, 0, frame.queryCount,
+            results.size() * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (result != VK_SUCCESS && result != VK_NOT_READY) {
+            throw std::runtime_error("failed to read timestamp queries!");
+        }
+
+        for (const auto& scope : frame.scopes) {
+            const uint64_t* begin = &results[scope.firstQuery * 2];
+            const uint64_t* end = &results[(scope.firstQuery + 1) * 2];
+            if (begin[1] == 0 || end[1] == 0) {
+                continue;
+            }
+            uint64_t ticks = (end[0] - begin[0]) & timestampMask;
+            ScopeHistory& scopeHistory = history[scope.nameIndex];
+            double milliseconds = ticks * timestampPeriod / 1e6;
+            if (scopeHistory.samples.size() < HISTORY_SIZE) {
+                scopeHistory.samples.push_back(milliseconds);
+            }
+            else {
+                scopeHistory.samples[scopeHistory.next] = milliseconds;
+            }
+            scopeHistory.next = (scopeHistory.next + 1) % HISTORY_SIZE;
+        }
+        frame.scopes.clear();
+        frame.queryCount = 0;
+    }
+
+    uint32_t GpuProfiler::nameIndex(const char* name) {
+        auto found = nameIndices.find(name);
+        if (found != nameIndices.end()) {
+            return found->second;
+        }
+        uint32_t index = static_cast<uint32_t>(names.size());
+        nameIndices.emplace(name, index);
+        names.emplace_back(name);
+        history.emplace_back();
+        return index;
+    }
+
+    void GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char* name) {
+        if (!currentFrame) {
+            return;
+        }
+        if (currentFrame->queryCount + 2 > MAX_SCOPES * 2) {
+            openScopes.push_back(UINT32_MAX);
+            return;
+        }
+
+        RecordedScope scope{ nameIndex(name), currentFrame->queryCount };
+        currentFrame->queryCount += 2;
+        openScopes.push_back(static_cast<uint32_t>(currentFrame->scopes.size()));
+        currentFrame->scopes.push_back(scope);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, currentFrame->pool, scope.firstQuery);
+    }
+
+    void GpuProfiler::endScope(VkCommandBuffer commandBuffer) {
+        if (!currentFrame) {
+            return;
+        }
+        assert(!openScopes.empty() && "endScope called without a matching beginScope");
+        uint32_t scopeIndex = openScopes.back();
+        openScopes.pop_back();
+        if (scopeIndex == UINT32_MAX) {
+            return;
+        }
+        const RecordedScope& scope = currentFrame->scopes[scopeIndex];
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, currentFrame->pool, scope.firstQuery + 1);
+    }
+
+    void GpuProfiler::clearHistory() {
+        firstCountedFrame = frameCount + 1;
+        for (auto& scopeHistory : history) {
+            scopeHistory.samples.clear();
+            scopeHistory.next = 0;
+        }
+    }
+
+    GpuScopeStats GpuProfiler::getStats(const std::string& name) const {
+        GpuScopeStats stats{};
+        stats.name = name;
+        auto found = nameIndices.find(name);
+        if (found == nameIndices.end() || history[found->second].samples.empty()) {
+            return stats;
+        }
+
+        std::vector<double> samples = history[found->second].samples;
+        std::sort(samples.begin(), samples.end());
+        double total = 0.0;
+        for (double sample : samples) {
+            total += sample;
+        }
+        size_t p99Index = std::min(samples.size() - 1, (samples.size() * 99) / 100);
+
+        stats.minMilliseconds = samples.front();
+        stats.avgMilliseconds = total / samples.size();
+        stats.p99Milliseconds = samples[p99Index];
+        stats.samples = samples.size();
+        return stats;
+    }
+
+    std::vector<GpuScopeStats> GpuProfiler::getAllStats() const {
+        std::vector<GpuScopeStats> allStats;
+        allStats.reserve(names.size());
+        for (const auto& name : names) {
+            allStats.push_back(getStats(name));
+        }
+        return allStats;
+    }
+
+    void GpuProfiler::printStats() const {
+        if (!supported) {
+            return;
+        }
+        std::cout << std::left << std::setw(20) << "GPU scope" << std::right
+            << std::setw(10) << "min ms" << std::setw(10) << "avg ms" << std::setw(10) << "p99 ms" << std::setw(10) << "samples" << std::endl;
+        std::cout << std::fixed << std::setprecision(3);
+        for (const auto& stats : getAllStats()) {
+            std::cout << std::left << std::setw(20) << stats.name << std::right
+                << std::setw(10) << stats.minMilliseconds << std::setw(10) << stats.avgMilliseconds
+                << std::setw(10) << stats.p99Milliseconds << std::setw(10) << stats.samples << std::endl;
+        }
+        std::cout << std::defaultfloat << std::setprecision(6);
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "device.hpp"
+#include <vulkan/vulkan.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vulkan {
+
+    struct GpuScopeStats {
+        std::string name;
+        double minMilliseconds = 0.0;
+        double avgMilliseconds = 0.0;
+        double p99Milliseconds = 0.0;
+        size_t samples = 0;
+    };
+
+    // Timestamp queries around named scopes, with one query pool per frame in flight.
+    // A frame's results are read when its slot comes round again, after acquireNextImage has waited for that
+    // slot's timeline value, so collection never blocks; queries the GPU has not finished yet are dropped, not waited for.
+    class GpuProfiler {
+    public:
+        static constexpr uint32_t MAX_SCOPES = 32;
+        static constexpr size_t HISTORY_SIZE = 256;
+
+        GpuProfiler(Device& device, uint32_t framesInFlight);
+        ~GpuProfiler();
+
+        GpuProfiler(const GpuProfiler&) = delete;
+        GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+        bool isSupported() const { return supported; }
+        void setEnabled(bool enabled) { this->enabled = enabled; }
+        bool isEnabled() const { return enabled && supported; }
+
+        // Collects the results last written for frameIndex, then resets its pool in commandBuffer.
+        void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+        // Scopes nest; endScope closes the most recently opened one.
+        void beginScope(VkCommandBuffer commandBuffer, const char* name);
+        void endScope(VkCommandBuffer commandBuffer);
+
+        // Rolling statistics over the last HISTORY_SIZE frames in which the scope ran.
+        GpuScopeStats getStats(const std::string& name) const;
+        // Forgets collected samples, e.g. to drop warm-up frames; results of frames begun before the call are discarded when they arrive.
+        void clearHistory();
+        std::vector<GpuScopeStats> getAllStats() const;
+        void printStats() const;
+
+    private:
+        struct RecordedScope {
+            uint32_t nameIndex;
+            uint32_t firstQuery;
+        };
+
+        struct FrameQueries {
+            VkQueryPool pool = VK_NULL_HANDLE;
+            std::vector<RecordedScope> scopes;
+            uint32_t queryCount = 0;
+            uint64_t frameNumber = 0;
+        };
+
+        struct ScopeHistory {
+            std::vector<double> samples;
+            size_t next = 0;
+        };
+
+        void collect(FrameQueries& frame);
+        uint32_t nameIndex(const char* name);
+
+        Device& device;
+        bool supported = false;
+        bool enabled = true;
+        double timestampPeriod = 1.0; // nanoseconds per tick
+        uint64_t timestampMask = ~0ull;
+
+        std::vector<FrameQueries> frames;
+        FrameQueries* currentFrame = nullptr;
+        std::vector<uint32_t> openScopes; // index into currentFrame->scopes, or UINT32_MAX when the pool was full
+        uint64_t frameCount = 0;
+        uint64_t firstCountedFrame = 0;   // frames numbered below this were recorded before clearHistory
+
+        std::unordered_map<std::string, uint32_t> nameIndices;
+        std::vector<std::string> names;
+        std::vector<ScopeHistory> history;
+    };
+
+    // Opens a scope for the lifetime of the object; a null profiler records nothing.
+    class GpuScope {
+    public:
+        GpuScope(GpuProfiler* profiler, VkCommandBuffer commandBuffer, const char* name)
+            : profiler{ profiler }, commandBuffer{ commandBuffer } {
+            if (profiler) {
+                profiler->beginScope(commandBuffer, name);
+            }
+        }
+        ~GpuScope() {
+            if (profiler) {
+                profiler->endScope(commandBuffer);
+            }
+        }
+
+        GpuScope(const GpuScope&) = delete;
+        GpuScope& operator=(const GpuScope&) = delete;
+
+    private:
+        GpuProfiler* profiler;
+        VkCommandBuffer commandBuffer;
+    };
+}
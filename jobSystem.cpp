@@ -0,0 +1,120 @@
+#include "jobSystem.hpp"
+#include "cpuProfiler.hpp"
+#include <algorithm>
+
+namespace vulkan {
+    unsigned JobSystem::defaultWorkerCount() {
+        unsigned hardwareThreads = std::thread::hardware_concurrency();
+        return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    JobSystem::JobSystem(unsigned workerCount) {
+        // The last queue belongs to the thread calling parallelFor.
+        for (unsigned i = 0; i <= workerCount; i++) {
+            queues.push_back(std::make_unique<WorkQueue>());
+        }
+        for (unsigned i = 0; i < workerCount; i++) {
+            workers.emplace_back(&JobSystem::workerLoop, this, i);
+        }
+    }
+
+    JobSystem::~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wakeCondition.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void JobSystem::parallelFor(size_t count, size_t chunkSize, const RangeJob& job) {
+        if (count == 0) {
+            return;
+        }
+        chunkSize = std::max<size_t>(chunkSize, 1);
+        size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+        if (deterministic || workers.empty() || chunkCount == 1) {
+            for (size_t begin = 0; begin < count; begin += chunkSize) {
+                job(begin, std::min(begin + chunkSize, count));
+            }
+            return;
+        }
+
+        std::atomic<size_t> remaining{ chunkCount };
+        // Counted before any task is visible: a worker that pops one decrements, and must never take the count below zero.
+        queuedTasks.fetch_add(chunkCount);
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            size_t begin = chunk * chunkSize;
+            Task task{ &job, begin, std::min(begin + chunkSize, count), &remaining };
+            auto& queue = *queues[chunk % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(task);
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wakeCondition.notify_all();
+
+        size_t callerIndex = queues.size() - 1;
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            Task task;
+            if (popLocal(callerIndex, task) || steal(callerIndex, task)) {
+                run(task);
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::workerLoop(size_t queueIndex) {
+        CpuProfiler::setThreadName("job worker");
+        while (true) {
+            Task task;
+            if (popLocal(queueIndex, task) || steal(queueIndex, task)) {
+                run(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wakeCondition.wait(lock, [this] { return stopping || queuedTasks.load() > 0; });
+            if (stopping) {
+                return;
+            }
+        }
+    }
+
+    bool JobSystem::popLocal(size_t queueIndex, Task& task) {
+        auto& queue = *queues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        queuedTasks.fetch_sub(1);
+        return true;
+    }
+
+    bool JobSystem::steal(size_t thiefIndex, Task& task) {
+        for (size_t offset = 1; offset < queues.size(); offset++) {
+            auto& queue = *queues[(thiefIndex + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+                queuedTasks.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void JobSystem::run(const Task& task) {
+        (*task.job)(task.begin, task.end);
+        task.remaining->fetch_sub(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vulkan {
+    // Small fork-join job system. Each worker owns a deque: it pops its own work from the back
+    // and steals from the front of the others' when it runs dry. The calling thread helps until its batch is done.
+    class JobSystem {
+    public:
+        using RangeJob = std::function<void(size_t begin, size_t end)>;
+
+        explicit JobSystem(unsigned workerCount = defaultWorkerCount());
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        // Splits [0, count) into chunkSize ranges and blocks until every range has run. Jobs must not throw.
+        void parallelFor(size_t count, size_t chunkSize, const RangeJob& job);
+
+        // Deterministic mode runs every chunk in index order on the calling thread, reproducing the single-threaded path exactly.
+        void setDeterministic(bool enabled) { deterministic = enabled; }
+        bool isDeterministic() const { return deterministic; }
+        unsigned getWorkerCount() const { return static_cast<unsigned>(workers.size()); }
+
+        static unsigned defaultWorkerCount();
+
+    private:
+        struct Task {
+            const RangeJob* job;
+            size_t begin;
+            size_t end;
+            std::atomic<size_t>* remaining;
+        };
+
+        struct WorkQueue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void workerLoop(size_t queueIndex);
+        bool popLocal(size_t queueIndex, Task& task);
+        bool steal(size_t thiefIndex, Task& task);
+        void run(const Task& task);
+
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        std::vector<std::thread> workers;
+        std::mutex sleepMutex;
+        std::condition_variable wakeCondition;
+        std::atomic<size_t> queuedTasks{ 0 };
+        bool stopping = false;
+        bool deterministic = false;
+    };
+}
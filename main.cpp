@@ -1,9 +1,15 @@
 #include "app.hpp"
-#include "compileShader.hpp"
+#include "global.hpp"
+#include "cpuProfiler.hpp"
+#include "benchmark.hpp"
+#include "goldenTest.hpp"
+#include "spriteKernels.hpp"
 
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 using namespace std;
 
@@ -24,8 +30,78 @@ float randomNumber(float min, float max) {
     return min + (max - min) * normalized;
 }
 
-int main() {
-    if (compile()) {
+void seedRandom(uint32_t seed) {
+    state = seed;
+}
+
+// Packs the same seeded sprites with every kernel this CPU supports; 10007 is not a multiple of the 4-sprite block.
+static bool checkSpriteKernels() {
+    bool allMatch = true;
+    for (const vulkan::SpriteKernelCheck& check : vulkan::compareSpriteKernels(10007)) {
+        string result = !check.supported ? "unsupported"
+            : check.kernel == vulkan::SpriteKernel::Scalar ? "reference"
+            : check.matchesScalar ? "match" : "MISMATCH";
+        allMatch = allMatch && (!check.supported || check.matchesScalar);
+        cout << "Sprite kernel " << vulkan::spriteKernelName(check.kernel) << ": " << result << endl;
+    }
+    return allMatch;
+}
+
+const vector<string> shaderSources = { "triangle.vert", "quad.vert", "triangle.frag", "sprite.comp", "cull.comp", "radixHistogram.comp",
+    "radixScan.comp", "radixScatter.comp", "drawRunCount.comp", "drawRunScan.comp", "drawRunEmit.comp", "drawRunSize.comp" };
+
+int main(int argc, char* argv[]) {
+    // --bake-shaders refreshes shaders.pak and exits, so the build can ship a warm archive.
+    bool bakeOnly = argc > 1 && string(argv[1]) == "--bake-shaders";
+    // --check-kernels compares the SIMD sprite kernels with the scalar one and fails on any difference; no GPU needed.
+    if (argc > 1 && string(argv[1]) == "--check-kernels") {
+        return checkSpriteKernels() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    // --trace <file> records CPU zones and writes them as Chrome trace JSON on exit.
+    string tracePath;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (string(argv[i]) == "--trace") {
+            tracePath = argv[i + 1];
+        }
+    }
+    vulkan::CpuProfiler::setEnabled(!tracePath.empty());
+    // --frames-in-flight N  --present low-latency|vsync|relaxed  --fps-limit N apply to every mode below.
+    try {
+        vulkan::frameSettings = vulkan::FrameSettings::parse(argc - 1, argv + 1);
+    }
+    catch (const exception& e) {
+        cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    vulkan::CpuProfiler::setThreadName("main");
+    if (vulkan::shaderArchive.build(shaderSources)) {
+        if (bakeOnly) {
+            return EXIT_SUCCESS;
+        }
+        // --golden [options] renders the reference scenes headless and diffs them against stored PNGs.
+        if (argc > 1 && string(argv[1]) == "--golden") {
+            try {
+                return vulkan::GoldenTest{ vulkan::GoldenTest::parseOptions(argc - 2, argv + 2) }.run() ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+            catch (const exception& e) {
+                cerr << e.what() << '\n';
+                return EXIT_FAILURE;
+            }
+        }
+        // --benchmark [options] sweeps sprite counts headless and writes CSV/JSON instead of opening the app.
+        if (argc > 1 && string(argv[1]) == "--benchmark") {
+            try {
+                bool passed = vulkan::Benchmark{ vulkan::Benchmark::parseOptions(argc - 2, argv + 2) }.run();
+                if (!tracePath.empty()) {
+                    vulkan::CpuProfiler::exportChromeTrace(tracePath);
+                }
+                return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+            catch (const exception& e) {
+                cerr << e.what() << '\n';
+                return EXIT_FAILURE;
+            }
+        }
         vulkan::App app{};
 
         try {
@@ -33,9 +109,15 @@ int main() {
         }
         catch (const exception& e) {
             cerr << e.what() << '\n';
+            if (!tracePath.empty()) {
+                vulkan::CpuProfiler::exportChromeTrace(tracePath);
+            }
             return EXIT_FAILURE;
         }
+        if (!tracePath.empty()) {
+            vulkan::CpuProfiler::exportChromeTrace(tracePath);
+        }
         return EXIT_SUCCESS;
     }
-    else { return 0; }
+    else { return bakeOnly ? EXIT_FAILURE : 0; }
 }
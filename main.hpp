@@ -1,8 +1,12 @@
 #ifndef MAIN_HPP
 #define MAIN_HPP
 
+#include <cstdint>
+
 extern short scene;
 
 float randomNumber(float min, float max);
+// Restarts the xorshift32 sequence behind randomNumber, for reproducible scenes.
+void seedRandom(uint32_t seed);
 
 #endif
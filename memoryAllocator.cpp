@@ -0,0 +1,264 @@
+#include "memoryAllocator.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+
+namespace vulkan {
+    MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice) : device{ device } {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        nonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+        maxAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+        pools.resize(memoryProperties.memoryTypeCount * 2);
+    }
+
+    MemoryAllocator::~MemoryAllocator() {
+        for (auto& pool : pools) {
+            for (auto& block : pool.blocks) {
+                if (!block) {
+                    continue;
+                }
+                if (block->allocationCount > 0) {
+                    std::cout << "Memory block released with " << block->allocationCount << " live allocations" << std::endl;
+                }
+                if (block->mapped) {
+                    vkUnmapMemory(device, block->memory);
+                }
+                vkFreeMemory(device, block->memory, nullptr);
+            }
+        }
+    }
+
+    uint32_t MemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+    MemoryAllocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        uint32_t memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+        VkMemoryPropertyFlags typeFlags = memoryProperties.memoryTypes[memoryType].propertyFlags;
+
+        // Non-coherent ranges are flushed in atom-sized units, so neighbours must not share an atom.
+        VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+        VkDeviceSize size = requirements.size;
+        if ((typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+            alignment = std::max(alignment, nonCoherentAtomSize);
+            size = (size + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize;
+        }
+
+        uint32_t pool = poolIndex(memoryType, linear);
+        auto& blocks = pools[pool].blocks;
+        VkDeviceSize blockSize = blockSizeFor(memoryType);
+
+        Block* target = nullptr;
+        VkDeviceSize offset = 0;
+        size_t blockIndex = 0;
+
+        if (size > blockSize / 2) {
+            // Large resources get a block of their own instead of fragmenting a shared one.
+            auto block = allocateBlock(memoryType, size);
+            block->dedicated = true;
+            block->freeRanges.clear();
+            target = block.get();
+            auto slot = std::find(blocks.begin(), blocks.end(), nullptr);
+            blockIndex = slot - blocks.begin();
+            if (slot == blocks.end()) {
+                blocks.push_back(std::move(block));
+            }
+            else {
+                *slot = std::move(block);
+            }
+        }
+        else {
+            for (blockIndex = 0; blockIndex < blocks.size(); blockIndex++) {
+                if (blocks[blockIndex] && suballocate(*blocks[blockIndex], size, alignment, offset)) {
+                    target = blocks[blockIndex].get();
+                    break;
+                }
+            }
+            if (!target) {
+                auto block = allocateBlock(memoryType, blockSize);
+                suballocate(*block, size, alignment, offset);
+                target = block.get();
+                auto slot = std::find(blocks.begin(), blocks.end(), nullptr);
+                blockIndex = slot - blocks.begin();
+                if (slot == blocks.end()) {
+                    blocks.push_back(std::move(block));
+                }
+                else {
+                    *slot = std::move(block);
+                }
+            }
+        }
+
+        target->allocationCount++;
+        target->usedBytes += size;
+
+        MemoryAllocation allocation;
+        allocation.memory = target->memory;
+        allocation.offset = offset;
+        allocation.size = size;
+        allocation.mapped = target->mapped ? static_cast<char*>(target->mapped) + offset : nullptr;
+        allocation.memoryType = memoryType;
+        allocation.poolIndex = pool;
+        allocation.blockIndex = static_cast<uint32_t>(blockIndex);
+        return allocation;
+    }
+
+    void MemoryAllocator::free(MemoryAllocation& allocation) {
+        if (allocation.memory == VK_NULL_HANDLE) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto& blocks = pools[allocation.poolIndex].blocks;
+        auto& block = blocks[allocation.blockIndex];
+        if (!block->dedicated) {
+            releaseRange(*block, allocation.offset, allocation.size);
+        }
+        block->allocationCount--;
+        block->usedBytes -= allocation.size;
+
+        // Keep one empty shared block per pool around so a load/unload cycle doesn't thrash vkAllocateMemory.
+        if (block->allocationCount == 0) {
+            size_t liveBlocks = std::count_if(blocks.begin(), blocks.end(),
+                [](const auto& candidate) { return candidate && !candidate->dedicated; });
+            if (block->dedicated || liveBlocks > 1) {
+                if (block->mapped) {
+                    vkUnmapMemory(device, block->memory);
+                }
+                vkFreeMemory(device, block->memory, nullptr);
+                deviceAllocationCount--;
+                block.reset();
+            }
+        }
+
+        allocation = MemoryAllocation{};
+    }
+
+    VkDeviceSize MemoryAllocator::blockSizeFor(uint32_t memoryType) const {
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryType].heapIndex].size;
+        // Small heaps (e.g. the 256 MiB BAR window) would be exhausted by a few default-sized blocks.
+        if (heapSize <= 1024ull * 1024 * 1024) {
+            return heapSize / 8;
+        }
+        return DEFAULT_BLOCK_SIZE;
+    }
+
+    std::unique_ptr<MemoryAllocator::Block> MemoryAllocator::allocateBlock(uint32_t memoryType, VkDeviceSize size) {
+        if (deviceAllocationCount >= maxAllocationCount) {
+            throw std::runtime_error("exceeded maxMemoryAllocationCount!");
+        }
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryType;
+
+        auto block = std::make_unique<Block>();
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &block->memory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate device memory block!");
+        }
+        deviceAllocationCount++;
+
+        if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            if (vkMapMemory(device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS) {
+                throw std::runtime_error("failed to map device memory block!");
+            }
+        }
+
+        block->size = size;
+        block->freeRanges[0] = size;
+        return block;
+    }
+
+    bool MemoryAllocator::suballocate(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) {
+        for (auto range = block.freeRanges.begin(); range != block.freeRanges.end(); ++range) {
+            VkDeviceSize start = range->first;
+            VkDeviceSize end = range->first + range->second;
+            VkDeviceSize aligned = (start + alignment - 1) / alignment * alignment;
+            if (aligned + size > end) {
+                continue;
+            }
+
+            // Alignment padding stays on the free list and merges back once a neighbour is released.
+            block.freeRanges.erase(range);
+            if (aligned > start) {
+                block.freeRanges[start] = aligned - start;
+            }
+            if (aligned + size < end) {
+                block.freeRanges[aligned + size] = end - (aligned + size);
+            }
+            offset = aligned;
+            return true;
+        }
+        return false;
+    }
+
+    void MemoryAllocator::releaseRange(Block& block, VkDeviceSize offset, VkDeviceSize size) {
+        auto inserted = block.freeRanges.emplace(offset, size).first;
+
+        auto next = std::next(inserted);
+        if (next != block.freeRanges.end() && inserted->first + inserted->second == next->first) {
+            inserted->second += next->second;
+            block.freeRanges.erase(next);
+        }
+        if (inserted != block.freeRanges.begin()) {
+            auto previous = std::prev(inserted);
+            if (previous->first + previous->second == inserted->first) {
+                previous->second += inserted->second;
+                block.freeRanges.erase(inserted);
+            }
+        }
+    }
+
+    void MemoryAllocator::addStats(MemoryStats& stats, uint32_t pool) const {
+        for (const auto& block : pools[pool].blocks) {
+            if (!block) {
+                continue;
+            }
+            stats.blockCount++;
+            stats.allocationCount += block->allocationCount;
+            stats.blockBytes += block->size;
+            stats.usedBytes += block->usedBytes;
+        }
+    }
+
+    MemoryStats MemoryAllocator::getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        MemoryStats stats;
+        for (uint32_t pool = 0; pool < pools.size(); pool++) {
+            addStats(stats, pool);
+        }
+        return stats;
+    }
+
+    MemoryStats MemoryAllocator::getStats(uint32_t memoryType) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        MemoryStats stats;
+        addStats(stats, poolIndex(memoryType, true));
+        addStats(stats, poolIndex(memoryType, false));
+        return stats;
+    }
+
+    void MemoryAllocator::printStats() const {
+        for (uint32_t type = 0; type < memoryProperties.memoryTypeCount; type++) {
+            MemoryStats stats = getStats(type);
+            if (stats.blockCount == 0) {
+                continue;
+            }
+            std::cout << "Memory type " << type << ": " << stats.allocationCount << " allocations in "
+                << stats.blockCount << " blocks, " << stats.usedBytes << "/" << stats.blockBytes << " bytes used" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace vulkan {
+    // A suballocated range of device memory. Bind resources at (memory, offset);
+    // host-visible allocations come back already mapped because their block is mapped once for its whole lifetime.
+    struct MemoryAllocation {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void* mapped = nullptr;
+        uint32_t memoryType = 0;
+        uint32_t poolIndex = 0;
+        uint32_t blockIndex = 0;
+    };
+
+    struct MemoryStats {
+        uint32_t blockCount = 0;
+        uint32_t allocationCount = 0;
+        VkDeviceSize blockBytes = 0;
+        VkDeviceSize usedBytes = 0;
+    };
+
+    // Keeps large blocks per memory type and hands out aligned ranges from a first-fit free list.
+    // Linear resources (buffers, linear images) and optimal-tiling images are kept in separate pools,
+    // so bufferImageGranularity never has to be checked.
+    class MemoryAllocator {
+    public:
+        static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+        MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice);
+        ~MemoryAllocator();
+
+        MemoryAllocator(const MemoryAllocator&) = delete;
+        MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+        MemoryAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear);
+        void free(MemoryAllocation& allocation);
+
+        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+        const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const { return memoryProperties; }
+
+        MemoryStats getStats() const;
+        MemoryStats getStats(uint32_t memoryType) const;
+        void printStats() const;
+
+    private:
+        struct Block {
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            VkDeviceSize size = 0;
+            void* mapped = nullptr;
+            uint32_t allocationCount = 0;
+            VkDeviceSize usedBytes = 0;
+            bool dedicated = false;
+            std::map<VkDeviceSize, VkDeviceSize> freeRanges; // offset -> size
+        };
+
+        // One pool per (memory type, linear/optimal) pair. Released blocks leave a null slot so indices stay stable.
+        struct Pool {
+            std::vector<std::unique_ptr<Block>> blocks;
+        };
+
+        uint32_t poolIndex(uint32_t memoryType, bool linear) const { return memoryType * 2 + (linear ? 0 : 1); }
+        VkDeviceSize blockSizeFor(uint32_t memoryType) const;
+        std::unique_ptr<Block> allocateBlock(uint32_t memoryType, VkDeviceSize size);
+        bool suballocate(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+        void releaseRange(Block& block, VkDeviceSize offset, VkDeviceSize size);
+        void addStats(MemoryStats& stats, uint32_t pool) const;
+
+        VkDevice device;
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        VkDeviceSize nonCoherentAtomSize;
+        uint32_t maxAllocationCount;
+        uint32_t deviceAllocationCount = 0;
+        std::vector<Pool> pools;
+        mutable std::mutex mutex;
+    };
+}
@@ -0,0 +1,84 @@
+#include "meshPool.hpp"
+#include "device.hpp"
+#include "uploadBatch.hpp"
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+
+namespace vulkan {
+    MeshPool::MeshPool(Device& device, uint32_t vertexStride) : device{ device }, vertexStride{ vertexStride } {
+        device.createBuffer(
+            static_cast<VkDeviceSize>(vertexStride) * VERTEX_CAPACITY,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            vertexBuffer,
+            vertexMemory
+        );
+        device.createBuffer(
+            sizeof(uint32_t) * INDEX_CAPACITY,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            indexBuffer,
+            indexMemory
+        );
+        std::cout << "Mesh pool created: " << VERTEX_CAPACITY << " vertices, " << INDEX_CAPACITY << " indices" << std::endl;
+    }
+
+    MeshPool::~MeshPool() {
+        device.destroyBuffer(indexBuffer, indexMemory);
+        device.destroyBuffer(vertexBuffer, vertexMemory);
+    }
+
+    uint32_t MeshPool::add(const void* vertices, uint32_t vertexCount, const std::vector<uint32_t>& indices, UploadBatch& upload) {
+        // Index-less models still go through the indexed multi-draw, with a generated 0..n-1 list.
+        std::vector<uint32_t> sequential;
+        const std::vector<uint32_t>* meshIndices = &indices;
+        if (indices.empty()) {
+            sequential.resize(vertexCount);
+            std::iota(sequential.begin(), sequential.end(), 0u);
+            meshIndices = &sequential;
+        }
+        uint32_t indexCount = static_cast<uint32_t>(meshIndices->size());
+
+        if (meshes.size() >= MAX_MESHES) {
+            throw std::runtime_error("mesh pool is out of mesh ids!");
+        }
+        if (vertexCount > VERTEX_CAPACITY - vertexCursor || indexCount > INDEX_CAPACITY - indexCursor) {
+            throw std::runtime_error("mesh pool is full!");
+        }
+
+        MeshRange range;
+        range.firstIndex = indexCursor;
+        range.indexCount = indexCount;
+        range.vertexOffset = static_cast<int32_t>(vertexCursor);
+        range.vertexCount = vertexCount;
+
+        upload.uploadToBuffer(vertexBuffer, vertices, static_cast<VkDeviceSize>(vertexStride) * vertexCount,
+            static_cast<VkDeviceSize>(vertexStride) * vertexCursor);
+        upload.uploadToBuffer(indexBuffer, meshIndices->data(), sizeof(uint32_t) * indexCount,
+            sizeof(uint32_t) * indexCursor);
+
+        vertexCursor += vertexCount;
+        indexCursor += indexCount;
+        liveMeshes++;
+        meshes.push_back(range);
+        return static_cast<uint32_t>(meshes.size() - 1);
+    }
+
+    void MeshPool::remove(uint32_t meshId) {
+        // An empty range keeps later ids stable and draws nothing.
+        meshes[meshId] = MeshRange{};
+        if (--liveMeshes == 0) {
+            meshes.clear();
+            vertexCursor = 0;
+            indexCursor = 0;
+        }
+    }
+
+    void MeshPool::bind(VkCommandBuffer commandBuffer) {
+        VkBuffer buffers[] = { vertexBuffer };
+        VkDeviceSize offsets[] = { 0 };
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "memoryAllocator.hpp"
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+
+namespace vulkan {
+    class Device;
+    class UploadBatch;
+
+    // Where a mesh lives in the shared buffers, in VkDrawIndexedIndirectCommand terms.
+    struct MeshRange {
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        int32_t vertexOffset = 0;
+        uint32_t vertexCount = 0;
+    };
+
+    // One vertex buffer and one index buffer shared by every Model, so a scene mixing models binds once and
+    // draws them all with a single multi-draw. Space is handed out front to back and only reclaimed when the
+    // last mesh is removed; the device must be idle by then, as it is whenever models are torn down.
+    class MeshPool {
+    public:
+        static constexpr uint32_t MAX_MESHES = 1024;
+        static constexpr uint32_t VERTEX_CAPACITY = 1 << 16;
+        static constexpr uint32_t INDEX_CAPACITY = 1 << 18;
+
+        MeshPool(Device& device, uint32_t vertexStride);
+        ~MeshPool();
+
+        MeshPool(const MeshPool&) = delete;
+        MeshPool& operator=(const MeshPool&) = delete;
+
+        // Records the upload into the batch and returns the mesh id. Without indices the vertices are drawn in order.
+        uint32_t add(const void* vertices, uint32_t vertexCount, const std::vector<uint32_t>& indices, UploadBatch& upload);
+        void remove(uint32_t meshId);
+
+        void bind(VkCommandBuffer commandBuffer);
+        const MeshRange& getRange(uint32_t meshId) const { return meshes[meshId]; }
+        // Ids are dense in [0, meshCount()); removed meshes keep their id, with an empty range, until the pool empties.
+        uint32_t meshCount() const { return static_cast<uint32_t>(meshes.size()); }
+
+    private:
+        Device& device;
+        uint32_t vertexStride;
+        VkBuffer vertexBuffer = VK_NULL_HANDLE;
+        MemoryAllocation vertexMemory;
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        MemoryAllocation indexMemory;
+        uint32_t vertexCursor = 0;
+        uint32_t indexCursor = 0;
+        uint32_t liveMeshes = 0;
+        std::vector<MeshRange> meshes;
+    };
+}
@@ -1,91 +1,43 @@
 #include "model.hpp"
+#include "uploadBatch.hpp"
 #include <cassert>
 #include <cstring>
 #include <iostream>
 
 namespace vulkan {
-    Model::Model(Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) : device{ device } {
-        createVertexBuffers(vertices);
-        createIndexBuffers(indices);
-    }
-
-    Model::~Model() {}
-
-    void Model::createVertexBuffers(const std::vector<Vertex>& vertices) {
+    Model::Model(Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, UploadBatch* batch) : device{ device } {
         vertexCount = static_cast<uint32_t>(vertices.size());
         assert(vertexCount >= 3 && "Vertex count must be at least 3");
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-        uint32_t vertexSize = sizeof(vertices[0]);
-
-        Buffer stagingBuffer{
-            device,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.write(vertices.data(), bufferSize);
-        stagingBuffer.unmap();
 
-        vertexBuffer = std::make_unique<Buffer>(
-            device,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-        );
-
-        device.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+        // Vertex and index data share one submit, or ride along in the caller's batch.
+        std::unique_ptr<UploadBatch> ownBatch;
+        UploadBatch& upload = batch ? *batch : *(ownBatch = std::make_unique<UploadBatch>(device));
+        MeshPool& pool = device.getMeshPool();
+        meshId = pool.add(vertices.data(), vertexCount, indices, upload);
+        indexCount = pool.getRange(meshId).indexCount;
+        if (ownBatch) {
+            ownBatch->submitAndWait();
+        }
     }
 
-    void Model::createIndexBuffers(const std::vector<uint32_t>& indices) {
-        indexCount = static_cast<uint32_t>(indices.size());
-        hasIndexBuffer = indexCount > 0;
-
-        if (!hasIndexBuffer) {
-            return;
+    Model::~Model() {
+        // A model outliving the pool has nothing left to free, and must not create a new pool on a dying device.
+        if (MeshPool* pool = device.findMeshPool()) {
+            pool->remove(meshId);
         }
-
-        VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-        uint32_t indexSize = sizeof(indices[0]);
-
-        Buffer stagingBuffer{
-            device,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.write(indices.data(), bufferSize);
-        stagingBuffer.unmap();
-
-        indexBuffer = std::make_unique<Buffer>(
-            device,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-        );
-
-        device.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
     }
 
     void Model::bind(VkCommandBuffer commandBuffer) {
-        VkBuffer buffers[] = { vertexBuffer->getBuffer() };
-        VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
-
-        if (hasIndexBuffer) {
-            vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-        }
+        device.getMeshPool().bind(commandBuffer);
     }
 
     void Model::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount) {
-        vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, 1);
+        const MeshRange& range = device.getMeshPool().getRange(meshId);
+        vkCmdDrawIndexed(commandBuffer, range.indexCount, instanceCount, range.firstIndex, range.vertexOffset, 1);
+    }
+
+    void Model::drawIndirect(VkCommandBuffer commandBuffer, VkBuffer indirectBuffer, VkDeviceSize offset) {
+        vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, offset, 1, sizeof(VkDrawIndexedIndirectCommand));
     }
 
     VkVertexInputBindingDescription Model::Vertex::getBindingDescription() {
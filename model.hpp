@@ -1,12 +1,12 @@
 #pragma once
 #include "device.hpp"
-#include "buffer.hpp"
 #include <vector>
 #include <vulkan/vulkan.h>
 #include <glm/glm.hpp>
-#include <memory> // Added for std::unique_ptr
 
 namespace vulkan {
+    class UploadBatch;
+
     class Model {
     public:
         struct Vertex {
@@ -18,24 +18,24 @@ namespace vulkan {
             static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
         };
 
-        Model(Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+        Model(Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, UploadBatch* batch = nullptr);
         ~Model();
 
         Model(const Model&) = delete;
         Model& operator=(const Model&) = delete;
 
+        // Binds the device's shared mesh pool; any model's bind serves every model.
         void bind(VkCommandBuffer commandBuffer);
         void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount);
+        void drawIndirect(VkCommandBuffer commandBuffer, VkBuffer indirectBuffer, VkDeviceSize offset);
+        uint32_t getIndexCount() const { return indexCount; }
+        // Index into the mesh pool, and into the per-mesh draw commands built by the cull pass.
+        uint32_t getMeshId() const { return meshId; }
 
     private:
-        void createVertexBuffers(const std::vector<Vertex>& vertices);
-        void createIndexBuffers(const std::vector<uint32_t>& indices);
-
         Device& device;
-        std::unique_ptr<Buffer> vertexBuffer;
+        uint32_t meshId;
         uint32_t vertexCount;
-        std::unique_ptr<Buffer> indexBuffer;
         uint32_t indexCount;
-        bool hasIndexBuffer;
     };
 }
\ No newline at end of file
@@ -3,14 +3,17 @@
 #include <stdexcept>
 #include <iostream>
 #include <cassert>
+#include <cmath>
 #include <random>
 #include "global.hpp"
+#include "uploadBatch.hpp"
 #include "main.hpp"
 
 namespace vulkan {
-    Pipeline::Pipeline(Device& device, const std::string& vertFilepath, const std::string& fragFilepath, VkRenderPass renderPass)
+    Pipeline::Pipeline(Device& device, const std::string& vertFilepath, const std::string& fragFilepath, VkRenderPass renderPass,
+        const VkSpecializationInfo* specialization, VertexInput vertexInput)
         : device{ device } {
-        createGraphicsPipeline(vertFilepath, fragFilepath, renderPass);
+        createGraphicsPipeline(vertFilepath, fragFilepath, renderPass, specialization, vertexInput);
     }
 
     Pipeline::~Pipeline() {
@@ -36,16 +39,11 @@ namespace vulkan {
         return buffer;
     }
 
-    void Pipeline::loadSprites() {
+    void Pipeline::loadSprites(size_t spriteCount, uint32_t modelCount) {
         std::cout << "Starting sprite loading...\n";
         std::vector<std::string> texturePaths = { "logo.jpg" };
-        sharedTexture = std::make_shared<Texture>(
-            device,
-            texturePaths[0],
-            descriptorSetLayout,
-            descriptorPool,
-            *this
-        );
+        UploadBatch upload{ device, UploadQueue::Transfer };
+        sharedTexture = std::make_shared<Texture>(device, texturePaths[0], &upload);
         std::vector<Model::Vertex> vertices = {
             {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
             {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
@@ -53,27 +51,47 @@ namespace vulkan {
             {{-0.5f, 0.5f}, {1.0f, 1.0f, 1.0f}, {0.0f, 1.0f}}
         };
         std::vector<uint32_t> indices = { 0, 1, 2, 2, 3, 0 };
-        auto sharedModel = std::make_shared<Model>(device, vertices, indices);
+        sharedModels.clear();
+        sharedModels.push_back(std::make_shared<Model>(device, vertices, indices, &upload));
+        for (uint32_t model = 1; model < modelCount; model++) {
+            // A polygon inscribed in the unit quad, fanned from its first corner.
+            uint32_t corners = model + 2;
+            vertices.clear();
+            indices.clear();
+            for (uint32_t corner = 0; corner < corners; corner++) {
+                float angle = 1.57079632679f + 6.28318530718f * corner / corners;
+                glm::vec2 position{ 0.5f * std::cos(angle), 0.5f * std::sin(angle) };
+                vertices.push_back({ position, {1.0f, 1.0f, 1.0f}, position + 0.5f });
+            }
+            for (uint32_t corner = 1; corner + 1 < corners; corner++) {
+                indices.insert(indices.end(), { 0, corner, corner + 1 });
+            }
+            sharedModels.push_back(std::make_shared<Model>(device, vertices, indices, &upload));
+        }
+        upload.submitAndWait();
+        std::cout << "Sprite assets uploaded with " << upload.getCommandCount() << " commands in one submit\n";
         sprites.clear();
+        sprites.reserve(spriteCount);
 
         Sprite sprite;
-        sprite.model = sharedModel;
         sprite.texture = sharedTexture.get();
 
-        for (int i = 0; i < 1000; i++) {
+        for (size_t i = 0; i < spriteCount; i++) {
+            sprite.model = sharedModels[i % sharedModels.size()];
             sprite.color = glm::vec3(1.0f, 1.0f, 1.0f);
             sprite.transform.translation = { randomNumber(-0.5f, 0.5f), randomNumber(-0.5f, 0.5f) };
             sprite.transform.scale = { 0.5f, 0.5f };
             sprite.transform.rotation = 0.0f;
             sprite.transform.speed = { randomNumber(-0.5f, 0.5f), randomNumber(-0.5f, 0.5f) };
-            sprites.push_back(sprite);
+            sprites.add(sprite);
         }
         std::cout << "Loaded " << sprites.size() << " sprites" << std::endl;
         }
 
-            void Pipeline::createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, VkRenderPass renderPass) {
-            auto vertCode = readFile(vertFilepath);
-            auto fragCode = readFile(fragFilepath);
+            void Pipeline::createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, VkRenderPass renderPass,
+                const VkSpecializationInfo* specialization, VertexInput vertexInput) {
+            auto vertCode = shaderArchive.getCode(vertFilepath);
+            auto fragCode = shaderArchive.getCode(fragFilepath);
             vertShaderModule = createShaderModule(vertCode);
             fragShaderModule = createShaderModule(fragCode);
 
@@ -82,19 +100,23 @@ namespace vulkan {
             shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
             shaderStages[0].module = vertShaderModule;
             shaderStages[0].pName = "main";
+            shaderStages[0].pSpecializationInfo = specialization;
             shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
             shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
             shaderStages[1].module = fragShaderModule;
             shaderStages[1].pName = "main";
+            shaderStages[1].pSpecializationInfo = specialization;
 
             VkVertexInputBindingDescription bindingDescription = Model::Vertex::getBindingDescription();
             auto attributeDescriptions = Model::Vertex::getAttributeDescriptions();
             VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
             vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-            vertexInputInfo.vertexBindingDescriptionCount = 1;
-            vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-            vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-            vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+            if (vertexInput == VertexInput::Model) {
+                vertexInputInfo.vertexBindingDescriptionCount = 1;
+                vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+                vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+                vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+            }
 
             VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
             inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -151,19 +173,50 @@ namespace vulkan {
             dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
             dynamicState.pDynamicStates = dynamicStates.data();
 
-            VkDescriptorSetLayoutBinding bindings[2] = {};
+            VkDescriptorSetLayoutBinding bindings[6] = {};
             bindings[0].binding = 0;
             bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
             bindings[0].descriptorCount = 1;
-            bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+            bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
             bindings[1].binding = 1;
-            bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
             bindings[1].descriptorCount = 1;
-            bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+            bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+            bindings[2].binding = 2;
+            bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[2].descriptorCount = 1;
+            bindings[2].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            // Mesh id and sort key of each sprite, read by the cull pass to group and order instances.
+            bindings[3].binding = 3;
+            bindings[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[3].descriptorCount = 1;
+            bindings[3].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            // Keys the cull pass writes for the radix sort.
+            bindings[4].binding = 4;
+            bindings[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[4].descriptorCount = 1;
+            bindings[4].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            // Bindless texture table; a variable-count binding has to be the last one in the set.
+            bindings[5].binding = 5;
+            bindings[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            bindings[5].descriptorCount = TextureRegistry::MAX_TEXTURES;
+            bindings[5].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+            VkDescriptorBindingFlags bindingFlags[6] = {};
+            bindingFlags[5] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+
+            VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+            bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+            bindingFlagsInfo.bindingCount = 6;
+            bindingFlagsInfo.pBindingFlags = bindingFlags;
 
             VkDescriptorSetLayoutCreateInfo layoutInfo{};
             layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-            layoutInfo.bindingCount = 2;
+            layoutInfo.pNext = &bindingFlagsInfo;
+            layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+            layoutInfo.bindingCount = 6;
             layoutInfo.pBindings = bindings;
 
             if (vkCreateDescriptorSetLayout(device.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
@@ -189,12 +242,13 @@ namespace vulkan {
 
             VkDescriptorPoolSize poolSizes[2] = {};
             poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            poolSizes[0].descriptorCount = 1000;
+            poolSizes[0].descriptorCount = TextureRegistry::MAX_TEXTURES * 2;
             poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
             poolSizes[1].descriptorCount = 1000;
 
             VkDescriptorPoolCreateInfo poolInfo{};
             poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
             poolInfo.poolSizeCount = 2;
             poolInfo.pPoolSizes = poolSizes;
             poolInfo.maxSets = 1000;
@@ -221,7 +275,7 @@ namespace vulkan {
             pipelineInfo.subpass = 0;
             pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-            if (vkCreateGraphicsPipelines(device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+            if (device.getPipelineCache().createGraphicsPipeline(pipelineInfo, &graphicsPipeline, vertFilepath.c_str()) != VK_SUCCESS) {
                 throw std::runtime_error("failed to create graphics pipeline!");
             }
         }
@@ -9,23 +9,33 @@
 #include "global.hpp"
 
 namespace vulkan {
+    enum class VertexInput {
+        Model, // Model::Vertex attributes from binding 0
+        None   // the vertex shader generates its own vertices from gl_VertexIndex
+    };
+
     class Pipeline {
     public:
-        Pipeline(Device& device, const std::string& vertFilepath, const std::string& fragFilepath, VkRenderPass renderPass);
+        // specialization, if given, is applied to both stages.
+        Pipeline(Device& device, const std::string& vertFilepath, const std::string& fragFilepath, VkRenderPass renderPass,
+            const VkSpecializationInfo* specialization = nullptr, VertexInput vertexInput = VertexInput::Model);
         ~Pipeline();
 
         Pipeline(const Pipeline&) = delete;
         Pipeline& operator=(const Pipeline&) = delete;
 
         void bind(VkCommandBuffer commandBuffer);
-        void loadSprites();
+        // Sprites cycle through modelCount models: the unit quad, then polygons with 3, 4, ... corners.
+        void loadSprites(size_t spriteCount = 1000, uint32_t modelCount = 1);
         VkPipelineLayout getPipelineLayout() { return pipelineLayout; }
         VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; } // Added
         VkDescriptorPool getDescriptorPool() const { return descriptorPool; }
 
-    private:
         static std::vector<char> readFile(const std::string& filepath);
-        void createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, VkRenderPass renderPass);
+
+    private:
+        void createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, VkRenderPass renderPass,
+            const VkSpecializationInfo* specialization, VertexInput vertexInput);
         VkShaderModule createShaderModule(const std::vector<char>& code);
 
         Device& device;
@@ -36,5 +46,6 @@ namespace vulkan {
         VkDescriptorSetLayout descriptorSetLayout;
         VkDescriptorPool descriptorPool;
         std::shared_ptr<Texture> sharedTexture;
+        std::vector<std::shared_ptr<Model>> sharedModels;
     };
 }
\ No newline at end of file
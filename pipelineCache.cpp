@@ -0,0 +1,158 @@
+#include "pipelineCache.hpp"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <iostream>
+
+namespace vulkan {
+    PipelineCache::PipelineCache(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& filepath, bool creationFeedback)
+        : device{ device }, properties{ properties }, filepath{ filepath }, creationFeedback{ creationFeedback } {
+        std::vector<char> data;
+        std::ifstream file{ filepath, std::ios::ate | std::ios::binary };
+        if (file.is_open()) {
+            data.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(data.data(), data.size());
+            if (!file || !validateHeader(data)) {
+                std::cout << "Discarding pipeline cache " << filepath << std::endl;
+                data.clear();
+            }
+        }
+
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = data.size();
+        cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+        // Drivers may still reject a blob with a valid header; fall back to an empty cache rather than failing startup.
+        if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &cache) != VK_SUCCESS) {
+            cacheInfo.initialDataSize = 0;
+            cacheInfo.pInitialData = nullptr;
+            if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &cache) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create pipeline cache!");
+            }
+            data.clear();
+        }
+        std::cout << "Pipeline cache loaded: " << data.size() << " bytes from " << filepath << std::endl;
+    }
+
+    PipelineCache::~PipelineCache() {
+        save();
+        printStats();
+        vkDestroyPipelineCache(device, cache, nullptr);
+    }
+
+    bool PipelineCache::validateHeader(const std::vector<char>& data) const {
+        // VkPipelineCacheHeaderVersionOne: length, version, vendorID, deviceID, pipelineCacheUUID.
+        if (data.size() < 16 + VK_UUID_SIZE) {
+            return false;
+        }
+        uint32_t headerLength, headerVersion, vendorID, deviceID;
+        memcpy(&headerLength, data.data(), 4);
+        memcpy(&headerVersion, data.data() + 4, 4);
+        memcpy(&vendorID, data.data() + 8, 4);
+        memcpy(&deviceID, data.data() + 12, 4);
+
+        return headerLength >= 16 + VK_UUID_SIZE && headerLength <= data.size() &&
+            headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+            vendorID == properties.vendorID &&
+            deviceID == properties.deviceID &&
+            memcmp(data.data() + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    VkResult PipelineCache::createGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo, VkPipeline* pipeline, const char* name) {
+        VkPipelineCreationFeedbackEXT feedback{};
+        VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo{};
+        VkGraphicsPipelineCreateInfo info = createInfo;
+        if (creationFeedback) {
+            feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+            feedbackInfo.pNext = info.pNext;
+            feedbackInfo.pPipelineCreationFeedback = &feedback;
+            info.pNext = &feedbackInfo;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        VkResult result = vkCreateGraphicsPipelines(device, cache, 1, &info, nullptr, pipeline);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        record(name, std::chrono::duration<double, std::milli>(end - start).count(), feedback);
+        return result;
+    }
+
+    VkResult PipelineCache::createComputePipeline(const VkComputePipelineCreateInfo& createInfo, VkPipeline* pipeline, const char* name) {
+        VkPipelineCreationFeedbackEXT feedback{};
+        VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo{};
+        VkComputePipelineCreateInfo info = createInfo;
+        if (creationFeedback) {
+            feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+            feedbackInfo.pNext = info.pNext;
+            feedbackInfo.pPipelineCreationFeedback = &feedback;
+            info.pNext = &feedbackInfo;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        VkResult result = vkCreateComputePipelines(device, cache, 1, &info, nullptr, pipeline);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        record(name, std::chrono::duration<double, std::milli>(end - start).count(), feedback);
+        return result;
+    }
+
+    void PipelineCache::record(const char* name, double milliseconds, const VkPipelineCreationFeedbackEXT& feedback) {
+        const char* outcome;
+        if (!(feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT)) {
+            stats.unknown++;
+            stats.unknownMilliseconds += milliseconds;
+            outcome = "created";
+        }
+        else if (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT) {
+            stats.hits++;
+            stats.hitMilliseconds += milliseconds;
+            outcome = "cache hit";
+        }
+        else {
+            stats.misses++;
+            stats.missMilliseconds += milliseconds;
+            outcome = "cache miss";
+        }
+        std::cout << "Pipeline " << name << ": " << outcome << " in " << milliseconds << " ms" << std::endl;
+    }
+
+    void PipelineCache::save() {
+        size_t size = 0;
+        if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS || size == 0) {
+            return;
+        }
+        std::vector<char> data(size);
+        if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS) {
+            std::cout << "Failed to read pipeline cache data" << std::endl;
+            return;
+        }
+
+        // Write beside the old file and swap it in, so a power cut mid-write never leaves a torn cache.
+        std::string tempPath = filepath + ".tmp";
+        {
+            std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+            file.write(data.data(), size);
+            if (!file) {
+                std::cout << "Failed to write pipeline cache " << tempPath << std::endl;
+                return;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(tempPath, filepath, error);
+        if (error) {
+            std::cout << "Failed to replace pipeline cache " << filepath << ": " << error.message() << std::endl;
+            return;
+        }
+        std::cout << "Pipeline cache saved: " << size << " bytes to " << filepath << std::endl;
+    }
+
+    void PipelineCache::printStats() const {
+        std::cout << "Pipeline cache: " << stats.hits << " hits (" << stats.hitMilliseconds << " ms), "
+            << stats.misses << " misses (" << stats.missMilliseconds << " ms), "
+            << stats.unknown << " without feedback (" << stats.unknownMilliseconds << " ms)" << std::endl;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vulkan {
+    struct PipelineCacheStats {
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        uint32_t unknown = 0; // created without VK_EXT_pipeline_creation_feedback
+        double hitMilliseconds = 0.0;
+        double missMilliseconds = 0.0;
+        double unknownMilliseconds = 0.0;
+    };
+
+    // VkPipelineCache backed by a file. The blob is only reused when its header matches this GPU and driver;
+    // anything else is discarded and the cache starts empty.
+    class PipelineCache {
+    public:
+        PipelineCache(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& filepath, bool creationFeedback);
+        ~PipelineCache();
+
+        PipelineCache(const PipelineCache&) = delete;
+        PipelineCache& operator=(const PipelineCache&) = delete;
+
+        VkPipelineCache getCache() const { return cache; }
+
+        // Wrap vkCreate*Pipelines to time each creation and record whether the cache served it.
+        VkResult createGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo, VkPipeline* pipeline, const char* name);
+        VkResult createComputePipeline(const VkComputePipelineCreateInfo& createInfo, VkPipeline* pipeline, const char* name);
+
+        void save();
+        const PipelineCacheStats& getStats() const { return stats; }
+        void printStats() const;
+
+    private:
+        bool validateHeader(const std::vector<char>& data) const;
+        void record(const char* name, double milliseconds, const VkPipelineCreationFeedbackEXT& feedback);
+
+        VkDevice device;
+        VkPhysicalDeviceProperties properties;
+        std::string filepath;
+        bool creationFeedback;
+        VkPipelineCache cache = VK_NULL_HANDLE;
+        PipelineCacheStats stats;
+    };
+}
@@ -0,0 +1,105 @@
+#include "pngImage.hpp"
+#include "stb_image.h"
+#include <algorithm>
+#include <array>
+#include <fstream>
+
+namespace vulkan {
+    static uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+        static const std::array<uint32_t, 256> table = [] {
+            std::array<uint32_t, 256> entries{};
+            for (uint32_t n = 0; n < 256; n++) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++) {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                entries[n] = c;
+            }
+            return entries;
+        }();
+
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++) {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    static void appendBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+        out.push_back(static_cast<uint8_t>(value >> 24));
+        out.push_back(static_cast<uint8_t>(value >> 16));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static void writeChunk(std::ofstream& file, const char* type, const std::vector<uint8_t>& data) {
+        std::vector<uint8_t> chunk;
+        appendBigEndian(chunk, static_cast<uint32_t>(data.size()));
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        appendBigEndian(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+        file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+    }
+
+    bool writePng(const std::string& filepath, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgba) {
+        if (rgba.size() != static_cast<size_t>(width) * height * 4) {
+            return false;
+        }
+
+        std::vector<uint8_t> header;
+        appendBigEndian(header, width);
+        appendBigEndian(header, height);
+        header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8-bit, RGBA, deflate, no filter, no interlace
+
+        // Every scanline is prefixed with filter type 0.
+        size_t rowSize = static_cast<size_t>(width) * 4;
+        std::vector<uint8_t> raw;
+        raw.reserve((rowSize + 1) * height);
+        for (uint32_t y = 0; y < height; y++) {
+            raw.push_back(0);
+            raw.insert(raw.end(), rgba.begin() + y * rowSize, rgba.begin() + (y + 1) * rowSize);
+        }
+
+        std::vector<uint8_t> zlib = { 0x78, 0x01 };
+        size_t offset = 0;
+        do {
+            size_t blockSize = std::min<size_t>(raw.size() - offset, 65535);
+            bool last = offset + blockSize == raw.size();
+            zlib.push_back(last ? 1 : 0);
+            zlib.push_back(static_cast<uint8_t>(blockSize));
+            zlib.push_back(static_cast<uint8_t>(blockSize >> 8));
+            zlib.push_back(static_cast<uint8_t>(~blockSize));
+            zlib.push_back(static_cast<uint8_t>(~blockSize >> 8));
+            zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+            offset += blockSize;
+        } while (offset < raw.size());
+
+        uint32_t a = 1, b = 0;
+        for (uint8_t byte : raw) {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+        appendBigEndian(zlib, (b << 16) | a);
+
+        std::ofstream file{ filepath, std::ios::binary | std::ios::trunc };
+        const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+        writeChunk(file, "IHDR", header);
+        writeChunk(file, "IDAT", zlib);
+        writeChunk(file, "IEND", {});
+        return static_cast<bool>(file);
+    }
+
+    bool readPng(const std::string& filepath, uint32_t& width, uint32_t& height, std::vector<uint8_t>& rgba) {
+        int fileWidth, fileHeight, channels;
+        stbi_uc* pixels = stbi_load(filepath.c_str(), &fileWidth, &fileHeight, &channels, STBI_rgb_alpha);
+        if (!pixels) {
+            return false;
+        }
+        width = static_cast<uint32_t>(fileWidth);
+        height = static_cast<uint32_t>(fileHeight);
+        rgba.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+        stbi_image_free(pixels);
+        return true;
+    }
+}
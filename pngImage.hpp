@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vulkan {
+    // 8-bit RGBA PNG files for captured frames and golden images. Writing uses stored (uncompressed)
+    // deflate blocks: larger files, but no zlib dependency and byte-identical output for identical pixels.
+    bool writePng(const std::string& filepath, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgba);
+    bool readPng(const std::string& filepath, uint32_t& width, uint32_t& height, std::vector<uint8_t>& rgba);
+}
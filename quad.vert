@@ -0,0 +1,72 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : enable
+
+// Vertex-pulling twin of triangle.vert: the unit quad is generated from gl_VertexIndex, so the
+// pipeline binds no vertex or index buffer and is drawn with six vertices per instance.
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint textureId;
+
+// Must match SpriteData in spriteData.hpp; checked by reflection when the pipeline is created.
+struct SpriteData {
+    vec2 translation;
+    vec2 speed;
+    vec2 scale;
+    uint color; // RGBA8
+    uint textureId;
+};
+
+// Must match CompactSpriteData in spriteData.hpp; aliases the same buffer when COMPACT_SPRITES is set.
+struct CompactSpriteData {
+    uint translation;     // half2
+    uint scale;           // half2
+    uint color;           // RGBA8
+    uint rotationTexture; // rotation in 1/65536 turns | texture index << 16
+};
+
+layout(constant_id = 0) const bool COMPACT_SPRITES = false;
+
+layout(std430, set = 0, binding = 0) readonly buffer SpriteBuffer {
+    SpriteData sprites[];
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer CompactSpriteBuffer {
+    CompactSpriteData compactSprites[];
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer VisibleBuffer {
+    uint visibleIndices[];
+};
+
+layout(push_constant) uniform Push {
+    mat4 projection;
+} push;
+
+// Same corners and winding as the Model quad in Pipeline::loadSprites (indices 0 1 2 2 3 0).
+const vec2 corners[6] = vec2[](
+    vec2(-0.5, -0.5), vec2(0.5, -0.5), vec2(0.5, 0.5),
+    vec2(0.5, 0.5), vec2(-0.5, 0.5), vec2(-0.5, -0.5)
+);
+
+void main() {
+    vec2 corner = corners[gl_VertexIndex];
+    uint instanceIndex = visibleIndices[gl_InstanceIndex];
+    vec2 pos;
+    if (COMPACT_SPRITES) {
+        CompactSpriteData sprite = compactSprites[instanceIndex];
+        float angle = float(sprite.rotationTexture & 0xffffu) * (6.28318530718 / 65536.0);
+        float c = cos(angle);
+        float s = sin(angle);
+        pos = mat2(c, s, -s, c) * (unpackHalf2x16(sprite.scale) * corner) + unpackHalf2x16(sprite.translation);
+        fragColor = unpackUnorm4x8(sprite.color).rgb;
+        textureId = sprite.rotationTexture >> 16;
+    }
+    else {
+        pos = sprites[instanceIndex].scale * corner + sprites[instanceIndex].translation;
+        fragColor = unpackUnorm4x8(sprites[instanceIndex].color).rgb;
+        textureId = sprites[instanceIndex].textureId;
+    }
+    gl_Position = push.projection * vec4(pos, 0.0, 1.0);
+    fragTexCoord = corner + 0.5;
+}
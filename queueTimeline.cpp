@@ -0,0 +1,94 @@
+#include "queueTimeline.hpp"
+#include "cpuProfiler.hpp"
+#include <stdexcept>
+
+namespace vulkan {
+    QueueTimeline::QueueTimeline(VkDevice device, VkQueue queue) : device{ device }, queue{ queue } {
+        VkSemaphoreTypeCreateInfo typeInfo{};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &typeInfo;
+        if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create timeline semaphore!");
+        }
+    }
+
+    QueueTimeline::~QueueTimeline() {
+        vkDestroySemaphore(device, semaphore, nullptr);
+    }
+
+    uint64_t QueueTimeline::submit(const VkCommandBuffer* commandBuffers, uint32_t commandBufferCount,
+        const std::vector<SemaphoreWait>& waits, VkSemaphore binarySignal) {
+        std::vector<VkSemaphore> waitSemaphores;
+        std::vector<uint64_t> waitValues;
+        std::vector<VkPipelineStageFlags> waitStages;
+        for (const SemaphoreWait& wait : waits) {
+            waitSemaphores.push_back(wait.semaphore);
+            waitValues.push_back(wait.value);
+            waitStages.push_back(wait.stage);
+        }
+
+        uint64_t value = lastSubmitted + 1;
+        VkSemaphore signalSemaphores[2] = { semaphore, binarySignal };
+        uint64_t signalValues[2] = { value, 0 };
+        uint32_t signalCount = binarySignal != VK_NULL_HANDLE ? 2 : 1;
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+        timelineInfo.pWaitSemaphoreValues = waitValues.data();
+        timelineInfo.signalSemaphoreValueCount = signalCount;
+        timelineInfo.pSignalSemaphoreValues = signalValues;
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+        submitInfo.pWaitSemaphores = waitSemaphores.data();
+        submitInfo.pWaitDstStageMask = waitStages.data();
+        submitInfo.commandBufferCount = commandBufferCount;
+        submitInfo.pCommandBuffers = commandBuffers;
+        submitInfo.signalSemaphoreCount = signalCount;
+        submitInfo.pSignalSemaphores = signalSemaphores;
+
+        VkResult result;
+        {
+            CPU_ZONE("queue submit");
+            result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+        }
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit to queue timeline!");
+        }
+        lastSubmitted = value;
+        return value;
+    }
+
+    void QueueTimeline::wait(uint64_t value) {
+        if (value <= lastCompleted) {
+            return;
+        }
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &semaphore;
+        waitInfo.pValues = &value;
+        if (vkWaitSemaphores(device, &waitInfo, UINT64_MAX) != VK_SUCCESS) {
+            throw std::runtime_error("failed to wait on queue timeline!");
+        }
+        lastCompleted = value;
+    }
+
+    bool QueueTimeline::isComplete(uint64_t value) {
+        if (value <= lastCompleted) {
+            return true;
+        }
+        uint64_t counter = 0;
+        vkGetSemaphoreCounterValue(device, semaphore, &counter);
+        lastCompleted = counter;
+        return value <= counter;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+
+namespace vulkan {
+    // Something a submit waits on first. Binary semaphores (swapchain acquire) ignore the value.
+    struct SemaphoreWait {
+        VkSemaphore semaphore;
+        uint64_t value;
+        VkPipelineStageFlags stage;
+    };
+
+    // One timeline semaphore per queue. Every submit through it signals the next value, so reaching value N means
+    // everything submitted up to N has finished: the host waits or polls on it instead of a fence per submit, and
+    // other queues wait on it on the GPU. Submits are made from one thread, in value order.
+    class QueueTimeline {
+    public:
+        QueueTimeline(VkDevice device, VkQueue queue);
+        ~QueueTimeline();
+
+        QueueTimeline(const QueueTimeline&) = delete;
+        QueueTimeline& operator=(const QueueTimeline&) = delete;
+
+        // Submits the command buffers after the waits and returns the value signalled when they finish.
+        // binarySignal is also signalled, for presentation, which only accepts binary semaphores.
+        uint64_t submit(const VkCommandBuffer* commandBuffers, uint32_t commandBufferCount,
+            const std::vector<SemaphoreWait>& waits = {}, VkSemaphore binarySignal = VK_NULL_HANDLE);
+
+        void wait(uint64_t value);
+        bool isComplete(uint64_t value);
+        // Waits on this timeline's value from another queue's submit.
+        SemaphoreWait waitFor(uint64_t value, VkPipelineStageFlags stage) const { return { semaphore, value, stage }; }
+
+        VkQueue getQueue() const { return queue; }
+        VkSemaphore getSemaphore() const { return semaphore; }
+        uint64_t getLastSubmitted() const { return lastSubmitted; }
+
+    private:
+        VkDevice device;
+        VkQueue queue;
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+        uint64_t lastSubmitted = 0;
+        uint64_t lastCompleted = 0; // cached so repeated checks of old values skip the driver call
+    };
+}
@@ -0,0 +1,144 @@
+#include "radixSort.hpp"
+#include <array>
+#include <iostream>
+#include <stdexcept>
+
+namespace vulkan {
+    static void computeBarrier(VkCommandBuffer commandBuffer) {
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    static_assert(RadixSort::PASSES % 2 == 0, "an even pass count leaves the sorted pairs in the caller's buffers");
+
+    RadixSort::RadixSort(Device& device, VkBuffer keys, VkBuffer values, uint32_t capacity)
+        : device{ device }, capacity{ capacity } {
+        uint32_t blockCount = (capacity + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        if (blockCount > device.properties.limits.maxComputeWorkGroupCount[0]) {
+            throw std::runtime_error("radix sort capacity exceeds the compute workgroup limit!");
+        }
+
+        VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        scratchKeys = std::make_unique<Buffer>(device, sizeof(uint32_t), capacity, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        scratchValues = std::make_unique<Buffer>(device, sizeof(uint32_t), capacity, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        // Digit-major block offsets, followed by the per-digit totals the scan writes.
+        histograms = std::make_unique<Buffer>(device, sizeof(uint32_t), RADIX * (blockCount + 1), usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        createDescriptorSets(keys, values);
+        histogramPipeline = std::make_unique<ComputePipeline>(device, "radixHistogram.comp.spv", descriptorSetLayout, sizeof(RadixPush));
+        scanPipeline = std::make_unique<ComputePipeline>(device, "radixScan.comp.spv", descriptorSetLayout, sizeof(RadixPush));
+        scatterPipeline = std::make_unique<ComputePipeline>(device, "radixScatter.comp.spv", descriptorSetLayout, sizeof(RadixPush));
+        std::cout << "Radix sort created for " << capacity << " keys in " << blockCount << " blocks" << std::endl;
+    }
+
+    RadixSort::~RadixSort() {
+        vkDestroyDescriptorPool(device.device(), descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(device.device(), descriptorSetLayout, nullptr);
+    }
+
+    void RadixSort::createDescriptorSets(VkBuffer keys, VkBuffer values) {
+        // 0, 1: keys and values in; 2, 3: keys and values out; 4: histograms.
+        VkDescriptorSetLayoutBinding bindings[5] = {};
+        for (uint32_t binding = 0; binding < 5; binding++) {
+            bindings[binding].binding = binding;
+            bindings[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[binding].descriptorCount = 1;
+            bindings[binding].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = 5;
+        layoutInfo.pBindings = bindings;
+        if (vkCreateDescriptorSetLayout(device.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create radix sort descriptor set layout!");
+        }
+
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSize.descriptorCount = 10;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        poolInfo.maxSets = 2;
+        if (vkCreateDescriptorPool(device.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create radix sort descriptor pool!");
+        }
+
+        VkDescriptorSetLayout layouts[2] = { descriptorSetLayout, descriptorSetLayout };
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = 2;
+        allocInfo.pSetLayouts = layouts;
+        if (vkAllocateDescriptorSets(device.device(), &allocInfo, descriptorSets) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate radix sort descriptor sets!");
+        }
+
+        VkBuffer passBuffers[2][4] = {
+            { keys, values, scratchKeys->getBuffer(), scratchValues->getBuffer() },
+            { scratchKeys->getBuffer(), scratchValues->getBuffer(), keys, values }
+        };
+        for (uint32_t set = 0; set < 2; set++) {
+            std::array<VkDescriptorBufferInfo, 5> bufferInfos{};
+            std::array<VkWriteDescriptorSet, 5> writes{};
+            for (uint32_t binding = 0; binding < 5; binding++) {
+                bufferInfos[binding].buffer = binding < 4 ? passBuffers[set][binding] : histograms->getBuffer();
+                bufferInfos[binding].offset = 0;
+                bufferInfos[binding].range = VK_WHOLE_SIZE;
+
+                writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[binding].dstSet = descriptorSets[set];
+                writes[binding].dstBinding = binding;
+                writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writes[binding].descriptorCount = 1;
+                writes[binding].pBufferInfo = &bufferInfos[binding];
+            }
+            vkUpdateDescriptorSets(device.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+        }
+    }
+
+    void RadixSort::record(VkCommandBuffer commandBuffer, uint32_t count) {
+        if (count > capacity) {
+            throw std::runtime_error("radix sort count exceeds its capacity!");
+        }
+        if (count == 0) {
+            return;
+        }
+
+        RadixPush push{};
+        push.count = count;
+        push.blockCount = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        uint32_t blockInvocations = push.blockCount * ComputePipeline::WORKGROUP_SIZE;
+
+        for (uint32_t pass = 0; pass < PASSES; pass++) {
+            push.shift = 8 * pass;
+            VkDescriptorSet descriptorSet = descriptorSets[pass % 2];
+
+            histogramPipeline->bind(commandBuffer);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, histogramPipeline->getPipelineLayout(), 0, 1, &descriptorSet, 0, nullptr);
+            vkCmdPushConstants(commandBuffer, histogramPipeline->getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RadixPush), &push);
+            histogramPipeline->dispatch(commandBuffer, blockInvocations);
+            computeBarrier(commandBuffer);
+
+            // One workgroup per digit walks that digit's row of block counts.
+            scanPipeline->bind(commandBuffer);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, scanPipeline->getPipelineLayout(), 0, 1, &descriptorSet, 0, nullptr);
+            vkCmdPushConstants(commandBuffer, scanPipeline->getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RadixPush), &push);
+            scanPipeline->dispatch(commandBuffer, RADIX * ComputePipeline::WORKGROUP_SIZE);
+            computeBarrier(commandBuffer);
+
+            scatterPipeline->bind(commandBuffer);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, scatterPipeline->getPipelineLayout(), 0, 1, &descriptorSet, 0, nullptr);
+            vkCmdPushConstants(commandBuffer, scatterPipeline->getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RadixPush), &push);
+            scatterPipeline->dispatch(commandBuffer, blockInvocations);
+            computeBarrier(commandBuffer);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "buffer.hpp"
+#include "computePipeline.hpp"
+#include "device.hpp"
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+
+namespace vulkan {
+    struct RadixPush {
+        uint32_t count;
+        uint32_t shift;
+        uint32_t blockCount;
+    };
+
+    // Stable LSD radix sort of 32-bit keys carrying 32-bit values, 8 bits per pass: a per-block digit histogram,
+    // a scan of those histograms, then a scatter in which every block sorts itself in shared memory first.
+    // Four passes ping-pong through scratch buffers, so the result lands back in the caller's buffers.
+    class RadixSort {
+    public:
+        static constexpr uint32_t BLOCK_SIZE = 1024; // elements per workgroup, four per invocation
+        static constexpr uint32_t RADIX = 256;
+        static constexpr uint32_t PASSES = 4;
+
+        RadixSort(Device& device, VkBuffer keys, VkBuffer values, uint32_t capacity);
+        ~RadixSort();
+
+        RadixSort(const RadixSort&) = delete;
+        RadixSort& operator=(const RadixSort&) = delete;
+
+        // Sorts the first count pairs in place. The caller makes its compute writes to keys and values visible
+        // before, and its own reads wait on the compute barrier recorded at the end.
+        void record(VkCommandBuffer commandBuffer, uint32_t count);
+
+    private:
+        void createDescriptorSets(VkBuffer keys, VkBuffer values);
+
+        Device& device;
+        uint32_t capacity;
+        std::unique_ptr<Buffer> scratchKeys;
+        std::unique_ptr<Buffer> scratchValues;
+        std::unique_ptr<Buffer> histograms;
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet descriptorSets[2] = {}; // caller -> scratch, scratch -> caller
+        std::unique_ptr<ComputePipeline> histogramPipeline;
+        std::unique_ptr<ComputePipeline> scanPipeline;
+        std::unique_ptr<ComputePipeline> scatterPipeline;
+    };
+}
@@ -1,22 +1,120 @@
 #include "renderSystem.hpp"
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
 #include <array>
+#include <cstring>
 #include <glm/gtc/matrix_transform.hpp>
 #include "global.hpp"
+#include "uploadBatch.hpp"
+#include "cpuProfiler.hpp"
+#include "spirvReflect.hpp"
+#include <unordered_set>
 
 namespace vulkan {
-    RenderSystem::RenderSystem(Device& device, Window& window, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout)
-        : device{ device }, descriptorSetLayout{ descriptorSetLayout }, window{ window } {
+    static_assert(TextureRegistry::MAX_TEXTURES <= 0x10000, "CompactSpriteData stores texture indices in 16 bits");
+    static_assert(TextureRegistry::MAX_TEXTURES <= 0x1000, "spriteSortKey stores texture indices in 12 bits");
+    static_assert(MeshPool::MAX_MESHES <= 0x800, "visibleKey keeps a texture bit below the mesh id for the culled-key clamp");
+
+    static void packSprite(const SpriteStore& store, size_t index, SpriteData& data) {
+        data.translation = store.positions()[index];
+        data.speed = store.velocities()[index];
+        data.scale = store.scales()[index];
+        data.color = packColor(store.colors()[index]);
+        data.textureId = store.textureIds()[index];
+    }
+
+    // Sprites without a model fall back to the first mesh.
+    static uint32_t meshIdOf(const Model* model) {
+        return model ? model->getMeshId() : 0;
+    }
+
+    static SpriteDrawInfo packDrawInfo(const SpriteStore& store, size_t index) {
+        SpriteDrawInfo info;
+        info.meshId = meshIdOf(store.models()[index]);
+        info.sortKey = spriteSortKey(store.layers()[index], store.depths()[index], store.textureIds()[index]);
+        return info;
+    }
+
+    // Matches DrawCommand in cull.comp.
+    static std::vector<BlockMember> drawCommandLayout() {
+        return {
+            { "indexCount", static_cast<uint32_t>(offsetof(VkDrawIndexedIndirectCommand, indexCount)) },
+            { "instanceCount", static_cast<uint32_t>(offsetof(VkDrawIndexedIndirectCommand, instanceCount)) },
+            { "firstIndex", static_cast<uint32_t>(offsetof(VkDrawIndexedIndirectCommand, firstIndex)) },
+            { "vertexOffset", static_cast<uint32_t>(offsetof(VkDrawIndexedIndirectCommand, vertexOffset)) },
+            { "firstInstance", static_cast<uint32_t>(offsetof(VkDrawIndexedIndirectCommand, firstInstance)) }
+        };
+    }
+
+    // Extends the previous copy when both its source and destination run on contiguously.
+    static void appendCopy(std::vector<VkBufferCopy>& copyRegions, VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkDeviceSize size) {
+        if (!copyRegions.empty() &&
+            copyRegions.back().srcOffset + copyRegions.back().size == srcOffset &&
+            copyRegions.back().dstOffset + copyRegions.back().size == dstOffset) {
+            copyRegions.back().size += size;
+        }
+        else {
+            copyRegions.push_back({ srcOffset, dstOffset, size });
+        }
+    }
+
+    static bool anyMoving(const glm::vec2* velocities, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (velocities[i].x != 0.0f || velocities[i].y != 0.0f) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void spriteBufferBarrier(VkCommandBuffer commandBuffer, VkBuffer buffer,
+        VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+
+    RenderSystem::RenderSystem(Device& device, Window& window, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout,
+        uint32_t framesInFlight, SpriteFormat spriteFormat, SpriteGeometry spriteGeometry, SpriteOrder spriteOrder)
+        : device{ device }, descriptorSetLayout{ descriptorSetLayout }, window{ window }, framesInFlight{ framesInFlight }, spriteFormat{ spriteFormat },
+        spriteGeometry{ spriteGeometry }, spriteOrder{ spriteOrder } {
+        if (spriteFormat == SpriteFormat::Compact) {
+            spriteMotion = SpriteMotion::Cpu;
+        }
+        meshSpriteCounts.assign(MeshPool::MAX_MESHES, 0);
+        drawCommands.reserve(MeshPool::MAX_MESHES);
         createPipelineLayout();
         createPipeline(renderPass);
-        std::cout << "RenderSystem created" << std::endl;
+        jobSystem = std::make_unique<JobSystem>();
+        std::cout << "RenderSystem created with " << jobSystem->getWorkerCount() << " update workers" << std::endl;
     }
 
     RenderSystem::~RenderSystem() {
+        if (spriteDataDescriptorSet != VK_NULL_HANDLE) {
+            textureRegistry.detach(spriteDataDescriptorSet);
+        }
         vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
     }
 
+    void RenderSystem::setSpriteMotion(SpriteMotion motion) {
+        if (motion == SpriteMotion::Gpu && spriteFormat == SpriteFormat::Compact) {
+            throw std::runtime_error("compact sprites carry no speed and cannot be integrated on the GPU!");
+        }
+        spriteMotion = motion;
+    }
+
+    VkDeviceSize RenderSystem::getSpriteRecordSize() const {
+        return spriteFormat == SpriteFormat::Compact ? sizeof(CompactSpriteData) : sizeof(SpriteData);
+    }
+
     void RenderSystem::initialize() {
         initializeSpriteData();
         createTextureArrayDescriptorSet();
@@ -41,12 +139,57 @@ namespace vulkan {
     }
 
     void RenderSystem::createPipeline(VkRenderPass renderPass) {
+        // A shader whose SpriteBuffer drifted from the C++ struct would read garbage, so refuse to start instead.
+        // The block the active specialization reads must be there; the aliased one is checked when present.
+        bool compact = spriteFormat == SpriteFormat::Compact;
+        for (const char* shader : { "triangle.vert.spv", "quad.vert.spv", "cull.comp.spv" }) {
+            std::vector<char> code = shaderArchive.getCode(shader);
+            validateStorageBlock(code, shader, 0, 0, "SpriteData", sizeof(SpriteData), spriteDataLayout(),
+                compact ? BlockRequirement::IfPresent : BlockRequirement::Required);
+            validateStorageBlock(code, shader, 0, 0, "CompactSpriteData", sizeof(CompactSpriteData), compactSpriteDataLayout(),
+                compact ? BlockRequirement::Required : BlockRequirement::IfPresent);
+        }
+        // sprite.comp integrates speed, which only the full record carries.
+        validateStorageBlock(shaderArchive.getCode("sprite.comp.spv"), "sprite.comp.spv", 0, 0, "SpriteData", sizeof(SpriteData),
+            spriteDataLayout());
+        std::vector<char> cullCode = shaderArchive.getCode("cull.comp.spv");
+        validateStorageBlock(cullCode, "cull.comp.spv", 0, 2, "DrawCommand", sizeof(VkDrawIndexedIndirectCommand), drawCommandLayout());
+        validateStorageBlock(cullCode, "cull.comp.spv", 0, 3, "SpriteDrawInfo", sizeof(SpriteDrawInfo), spriteDrawInfoLayout());
+
+        // constant_id 0 is COMPACT_SPRITES in triangle.vert, quad.vert and cull.comp.
+        VkBool32 compactSprites = spriteFormat == SpriteFormat::Compact ? VK_TRUE : VK_FALSE;
+        VkSpecializationMapEntry compactEntry{ 0, 0, sizeof(VkBool32) };
+        VkSpecializationInfo specialization{ 1, &compactEntry, sizeof(VkBool32), &compactSprites };
+
+        bool pullVertices = spriteGeometry == SpriteGeometry::VertexPulling;
         pipeline = std::make_unique<Pipeline>(
             device,
-            "triangle.vert.spv",
+            pullVertices ? "quad.vert.spv" : "triangle.vert.spv",
             "triangle.frag.spv",
-            renderPass
+            renderPass,
+            &specialization,
+            pullVertices ? VertexInput::None : VertexInput::Model
+        );
+        motionPipeline = std::make_unique<ComputePipeline>(
+            device,
+            "sprite.comp.spv",
+            descriptorSetLayout,
+            sizeof(MotionPush)
         );
+        cullPipeline = std::make_unique<ComputePipeline>(
+            device,
+            "cull.comp.spv",
+            descriptorSetLayout,
+            sizeof(CullPush),
+            &specialization
+        );
+        if (spriteOrder == SpriteOrder::Sorted && !pullVertices) {
+            std::vector<char> emitCode = shaderArchive.getCode("drawRunEmit.comp.spv");
+            for (uint32_t binding : { 1u, 2u }) {
+                validateStorageBlock(emitCode, "drawRunEmit.comp.spv", 0, binding, "DrawCommand", sizeof(VkDrawIndexedIndirectCommand),
+                    drawCommandLayout());
+            }
+        }
     }
 
     void RenderSystem::initializeSpriteData() {
@@ -60,49 +203,101 @@ namespace vulkan {
             std::cout << "Sprite count: " << sprites.size() << "\n";
         }
 
-        std::vector<SpriteData> spriteData(sprites.size());
-        for (size_t i = 0; i < sprites.size(); i++) {
-            auto& sprite = sprites[i];
-            spriteData[i].translation = sprite.transform.translation;
-            float scale = sprite.transform.scale.x;
-            spriteData[i].transform = glm::mat2(scale, 0.0f, 0.0f, scale);
-            spriteData[i].color = sprite.color;
-            spriteData[i].textureId = 0;
-            spriteData[i].speed = sprite.transform.speed;
-            spriteData[i].padding = 0.0f;
+        spriteCapacity = sprites.size();
+        VkDeviceSize bufferSize = getSpriteRecordSize() * spriteCapacity;
+        VkDeviceSize drawInfoSize = sizeof(SpriteDrawInfo) * spriteCapacity;
+
+        // Sprites are packed straight into the batch's staging memory.
+        UploadBatch upload{ device, UploadQueue::Transfer };
+        VkBuffer stagingBuffer;
+        VkDeviceSize stagingOffset;
+        void* staging = upload.stage(bufferSize, stagingBuffer, stagingOffset);
+        if (spriteFormat == SpriteFormat::Compact) {
+            auto* spriteData = static_cast<CompactSpriteData*>(staging);
+            for (size_t i = 0; i < sprites.size(); i++) {
+                spriteData[i] = packCompactSprite(sprites.positions()[i], sprites.scales()[i], sprites.colors()[i],
+                    sprites.rotations()[i], sprites.textureIds()[i]);
+            }
+        }
+        else {
+            auto* spriteData = static_cast<SpriteData*>(staging);
+            for (size_t i = 0; i < sprites.size(); i++) {
+                packSprite(sprites, i, spriteData[i]);
+            }
         }
 
-        VkDeviceSize bufferSize = sizeof(SpriteData) * sprites.size();
-        std::cout << "SSBO size: " << bufferSize << " bytes, SpriteData size: " << sizeof(SpriteData) << " bytes\n";
+        std::cout << "SSBO size: " << bufferSize << " bytes, " << (spriteFormat == SpriteFormat::Compact ? "CompactSpriteData" : "SpriteData")
+            << " size: " << getSpriteRecordSize() << " bytes\n";
+        std::cout << "Sprite packing kernel: " << spriteKernelName(activeSpriteKernel()) << "\n";
 
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
-        device.createBuffer(
+        spriteDataBuffer = std::make_unique<Buffer>(
+            device,
             bufferSize,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            stagingBuffer,
-            stagingBufferMemory
+            1,
+            // Transfer source too: moveSpriteRecords copies records within the buffer.
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            device.properties.limits.minStorageBufferOffsetAlignment
         );
 
-        void* data;
-        vkMapMemory(device.device(), stagingBufferMemory, 0, bufferSize, 0, &data);
-        memcpy(data, spriteData.data(), static_cast<size_t>(bufferSize));
-        vkUnmapMemory(device.device(), stagingBufferMemory);
+        upload.copyBuffer(stagingBuffer, spriteDataBuffer->getBuffer(), bufferSize, stagingOffset);
 
-        spriteDataBuffer = std::make_unique<Buffer>(
+        spriteDrawBuffer = std::make_unique<Buffer>(
             device,
-            bufferSize,
+            drawInfoSize,
             1,
             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             device.properties.limits.minStorageBufferOffsetAlignment
         );
+        auto* drawInfo = static_cast<SpriteDrawInfo*>(upload.stage(drawInfoSize, stagingBuffer, stagingOffset));
+        spriteMeshIds.resize(sprites.size());
+        std::fill(meshSpriteCounts.begin(), meshSpriteCounts.end(), 0);
+        for (size_t i = 0; i < sprites.size(); i++) {
+            drawInfo[i] = packDrawInfo(sprites, i);
+            spriteMeshIds[i] = drawInfo[i].meshId;
+            meshSpriteCounts[spriteMeshIds[i]]++;
+        }
+        upload.copyBuffer(stagingBuffer, spriteDrawBuffer->getBuffer(), drawInfoSize, stagingOffset);
+        upload.submitAndWait();
 
-        device.copyBuffer(stagingBuffer, spriteDataBuffer->getBuffer(), bufferSize);
+        // Each frame's region holds the sprite records followed by the draw info of the sprites that changed.
+        spriteUploadRing = std::make_unique<StagingRing>(device, bufferSize + drawInfoSize, framesInFlight);
 
-        vkDestroyBuffer(device.device(), stagingBuffer, nullptr);
-        vkFreeMemory(device.device(), stagingBufferMemory, nullptr);
+        visibleIndexBuffer = std::make_unique<Buffer>(
+            device,
+            sizeof(uint32_t),
+            static_cast<uint32_t>(sprites.size()),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+        drawCommandBuffer = std::make_unique<Buffer>(
+            device,
+            sizeof(VkDrawIndexedIndirectCommand),
+            MeshPool::MAX_MESHES,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+        // Unsorted, the cull pass never writes keys; the binding still needs a buffer behind it.
+        sortKeyBuffer = std::make_unique<Buffer>(
+            device,
+            sizeof(uint32_t),
+            spriteOrder == SpriteOrder::Sorted ? static_cast<uint32_t>(spriteCapacity) : 1,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+        if (spriteOrder == SpriteOrder::Sorted) {
+            radixSort = std::make_unique<RadixSort>(device, sortKeyBuffer->getBuffer(), visibleIndexBuffer->getBuffer(),
+                static_cast<uint32_t>(spriteCapacity));
+        }
+        // Without these a sorted list can only be drawn by one command, which cullSprites enforces.
+        if (spriteOrder == SpriteOrder::Sorted && spriteGeometry == SpriteGeometry::Model && device.hasDrawIndirectCount() &&
+            device.getEnabledFeatures().multiDrawIndirect) {
+            drawRuns = std::make_unique<DrawRuns>(device, sortKeyBuffer->getBuffer(), drawCommandBuffer->getBuffer(),
+                static_cast<uint32_t>(spriteCapacity));
+        }
+        sprites.takeDirtyRanges();
+        sprites.takeMoves();
 
         std::cout << "Initialized " << sprites.size() << " sprites in SSBO" << std::endl;
     }
@@ -118,6 +313,13 @@ namespace vulkan {
         allocInfo.descriptorSetCount = 1;
         allocInfo.pSetLayouts = &descriptorSetLayout;
 
+        uint32_t textureCapacity = TextureRegistry::MAX_TEXTURES;
+        VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{};
+        variableCountInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+        variableCountInfo.descriptorSetCount = 1;
+        variableCountInfo.pDescriptorCounts = &textureCapacity;
+        allocInfo.pNext = &variableCountInfo;
+
         if (vkAllocateDescriptorSets(device.device(), &allocInfo, &spriteDataDescriptorSet) != VK_SUCCESS) {
             throw std::runtime_error("failed to allocate descriptor set!");
         }
@@ -125,7 +327,7 @@ namespace vulkan {
         VkDescriptorBufferInfo bufferInfo{};
         bufferInfo.buffer = spriteDataBuffer->getBuffer();
         bufferInfo.offset = 0;
-        bufferInfo.range = sizeof(SpriteData) * vulkan::sprites.size();
+        bufferInfo.range = getSpriteRecordSize() * vulkan::sprites.size();
 
         VkWriteDescriptorSet bufferWrite{};
         bufferWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -136,40 +338,69 @@ namespace vulkan {
         bufferWrite.descriptorCount = 1;
         bufferWrite.pBufferInfo = &bufferInfo;
 
-        VkDescriptorImageInfo imageInfo{};
-        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo.imageView = vulkan::sprites[0].texture->getImageView();
-        imageInfo.sampler = vulkan::sprites[0].texture->getSampler();
-
-        VkWriteDescriptorSet imageWrite{};
-        imageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        imageWrite.dstSet = spriteDataDescriptorSet;
-        imageWrite.dstBinding = 1;
-        imageWrite.dstArrayElement = 0;
-        imageWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        imageWrite.descriptorCount = 1;
-        imageWrite.pImageInfo = &imageInfo;
-
-        std::array<VkWriteDescriptorSet, 2> descriptorWrites = { bufferWrite, imageWrite };
+        VkDescriptorBufferInfo visibleInfo{};
+        visibleInfo.buffer = visibleIndexBuffer->getBuffer();
+        visibleInfo.offset = 0;
+        visibleInfo.range = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet visibleWrite = bufferWrite;
+        visibleWrite.dstBinding = 1;
+        visibleWrite.pBufferInfo = &visibleInfo;
+
+        VkDescriptorBufferInfo drawInfo{};
+        drawInfo.buffer = drawCommandBuffer->getBuffer();
+        drawInfo.offset = 0;
+        drawInfo.range = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet drawWrite = bufferWrite;
+        drawWrite.dstBinding = 2;
+        drawWrite.pBufferInfo = &drawInfo;
+
+        VkDescriptorBufferInfo drawInfoInfo{};
+        drawInfoInfo.buffer = spriteDrawBuffer->getBuffer();
+        drawInfoInfo.offset = 0;
+        drawInfoInfo.range = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet drawInfoWrite = bufferWrite;
+        drawInfoWrite.dstBinding = 3;
+        drawInfoWrite.pBufferInfo = &drawInfoInfo;
+
+        VkDescriptorBufferInfo sortKeyInfo{};
+        sortKeyInfo.buffer = sortKeyBuffer->getBuffer();
+        sortKeyInfo.offset = 0;
+        sortKeyInfo.range = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet sortKeyWrite = bufferWrite;
+        sortKeyWrite.dstBinding = 4;
+        sortKeyWrite.pBufferInfo = &sortKeyInfo;
+
+        std::array<VkWriteDescriptorSet, 5> descriptorWrites = { bufferWrite, visibleWrite, drawWrite, drawInfoWrite, sortKeyWrite };
         vkUpdateDescriptorSets(device.device(), descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
 
+        // Binding 5 is the bindless texture table; the registry fills it and keeps it current as textures come and go.
+        textureRegistry.attach(device, spriteDataDescriptorSet, 5);
+
         std::cout << "Descriptor set bound for " << vulkan::sprites.size() << " sprites" << std::endl;
     }
 
     void RenderSystem::renderSprites(VkCommandBuffer commandBuffer) {
+        GpuScope scope{ profiler, commandBuffer, "render sprites" };
         pipeline->bind(commandBuffer);
         if (sprites.empty()) {
             std::cerr << "No sprites to render" << std::endl;
             return;
         }
-        auto model = sprites[0].model;
-        if (!model) {
-            std::cerr << "Invalid model for sprite rendering" << std::endl;
-            return;
+        MeshPool* meshes = nullptr;
+        if (spriteGeometry == SpriteGeometry::Model) {
+            meshes = &device.getMeshPool();
+            if (meshes->meshCount() == 0) {
+                std::cerr << "No models for sprite rendering" << std::endl;
+                return;
+            }
+            // Every model lives in the same two buffers, so one bind serves all of them.
+            meshes->bind(commandBuffer);
         }
 
-        model->bind(commandBuffer);
-
         vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->getPipelineLayout(), 0, 1, &spriteDataDescriptorSet, 0, nullptr);
 
         Push push{};
@@ -178,47 +409,370 @@ namespace vulkan {
         push.projection = glm::ortho(-aspectRatio, aspectRatio, -1.0f, 1.0f, -1.0f, 1.0f);
         vkCmdPushConstants(commandBuffer, pipeline->getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(Push), &push);
 
-        uint32_t instanceCount = static_cast<uint32_t>(std::min(sprites.size(), size_t(std::numeric_limits<uint32_t>::max())));
-        model->draw(commandBuffer, instanceCount);
+        // Instance counts come from the cull pass; each instance looks up its sprite through the visible index list,
+        // and gl_InstanceIndex already includes the mesh's firstInstance.
+        if (spriteGeometry == SpriteGeometry::VertexPulling) {
+            vkCmdDrawIndirect(commandBuffer, drawCommandBuffer->getBuffer(), 0, 1, sizeof(VkDrawIndirectCommand));
+        }
+        else if (drawRuns) {
+            drawRuns->draw(commandBuffer);
+        }
+        else if (device.getEnabledFeatures().multiDrawIndirect) {
+            vkCmdDrawIndexedIndirect(commandBuffer, drawCommandBuffer->getBuffer(), 0, meshes->meshCount(), sizeof(VkDrawIndexedIndirectCommand));
+        }
+        else {
+            for (uint32_t mesh = 0; mesh < meshes->meshCount(); mesh++) {
+                vkCmdDrawIndexedIndirect(commandBuffer, drawCommandBuffer->getBuffer(), sizeof(VkDrawIndexedIndirectCommand) * mesh,
+                    1, sizeof(VkDrawIndexedIndirectCommand));
+            }
+        }
     }
 
-    void RenderSystem::updateSprites(float deltaTime) {
-        std::vector<SpriteData> spriteData(sprites.size());
+    void RenderSystem::updateSprites(VkCommandBuffer commandBuffer, uint32_t frameIndex, float deltaTime) {
+        CPU_ZONE("updateSprites");
+        if (!spriteUploadRing || sprites.empty()) {
+            return;
+        }
+        if (sprites.size() > spriteCapacity) {
+            throw std::runtime_error("sprite count exceeds upload ring capacity!");
+        }
+        if (frameIndex >= spriteUploadRing->getRegionCount()) {
+            throw std::runtime_error("frame index is outside the upload ring; the renderer and render system disagree on frames in flight!");
+        }
 
-        for (size_t i = 0; i < sprites.size(); i++) {
-            auto& sprite = sprites[i];
+        uploadedBytes = 0;
+        std::vector<SpriteRange> dirtyRanges = sprites.takeDirtyRanges();
+        // The CPU path repacks moved sprites from the host arrays, which are current there.
+        std::vector<SpriteMove> moves = sprites.takeMoves();
 
-            sprite.transform.translation += sprite.transform.speed * deltaTime;
+        if (spriteMotion == SpriteMotion::Cpu) {
+            streamChangedSprites(commandBuffer, frameIndex, deltaTime, dirtyRanges);
+        }
+        else {
+            moveSpriteRecords(commandBuffer, moves);
+            uploadChangedSprites(commandBuffer, frameIndex, dirtyRanges, moves);
+            integrateOnGpu(commandBuffer, deltaTime);
+        }
+        uploadSpriteDrawInfo(commandBuffer, frameIndex, dirtyRanges);
+        cullSprites(commandBuffer);
+    }
+
+    void RenderSystem::streamChangedSprites(VkCommandBuffer commandBuffer, uint32_t frameIndex, float deltaTime,
+        const std::vector<SpriteRange>& dirtyRanges) {
+        // The ring region for this frame is free: acquireNextImage already waited for its timeline value.
+        void* region = spriteUploadRing->getRegion(frameIndex);
+        const size_t chunkSize = SpriteStore::DIRTY_CHUNK_SIZE;
+        size_t chunkCount = (sprites.size() + chunkSize - 1) / chunkSize;
+
+        // A chunk with no flagged and no moving sprite is already current in the SSBO and is skipped entirely.
+        changedChunks.assign(chunkCount, 0);
+        for (const SpriteRange& range : dirtyRanges) {
+            for (size_t chunk = range.begin / chunkSize; chunk <= (range.end - 1) / chunkSize; chunk++) {
+                changedChunks[chunk] = 1;
+            }
+        }
 
-            spriteData[i].translation = sprite.transform.translation;
-            float scale = sprite.transform.scale.x;
-            spriteData[i].transform = glm::mat2(scale, 0.0f, 0.0f, scale);
-            spriteData[i].color = sprite.color;
-            spriteData[i].textureId = 0;
-            spriteData[i].speed = sprite.transform.speed;
-            spriteData[i].padding = 0.0f;
+        auto pack = [&](const SpriteStreams& streams, size_t begin, size_t end) {
+            if (spriteFormat == SpriteFormat::Compact) {
+                integrateAndPackCompactSprites(streams, begin, end - begin, deltaTime, static_cast<CompactSpriteData*>(region) + begin);
+            }
+            else {
+                integrateAndPackSprites(streams, begin, end - begin, deltaTime, static_cast<SpriteData*>(region) + begin);
+            }
+        };
+
+        // Jobs write disjoint ranges of the mapped region and of changedChunks; dirty chunks are a multiple of the
+        // 4-sprite SIMD block, and runs of changed chunks are packed with one kernel call.
+        SpriteStreams streams = makeSpriteStreams(sprites);
+        jobSystem->parallelFor(sprites.size(), UPDATE_CHUNK_SIZE, [&](size_t begin, size_t end) {
+            CPU_ZONE("integrate chunk");
+            size_t runBegin = end;
+            for (size_t first = begin; first < end; first += chunkSize) {
+                size_t last = std::min(first + chunkSize, end);
+                uint8_t& changed = changedChunks[first / chunkSize];
+                changed = changed || anyMoving(streams.velocities, first, last);
+                if (changed && runBegin == end) {
+                    runBegin = first;
+                }
+                else if (!changed && runBegin != end) {
+                    pack(streams, runBegin, first);
+                    runBegin = end;
+                }
+            }
+            if (runBegin != end) {
+                pack(streams, runBegin, end);
+            }
+        });
+
+        // Records sit at their own index in the region, so neighbouring changed chunks coalesce into one copy.
+        VkDeviceSize recordSize = getSpriteRecordSize();
+        VkDeviceSize regionOffset = spriteUploadRing->getRegionOffset(frameIndex);
+        std::vector<VkBufferCopy> copyRegions;
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            if (changedChunks[chunk]) {
+                size_t first = chunk * chunkSize;
+                size_t count = std::min(chunkSize, sprites.size() - first);
+                appendCopy(copyRegions, regionOffset + recordSize * first, recordSize * first, recordSize * count);
+                uploadedBytes += recordSize * count;
+            }
+        }
+        if (copyRegions.empty()) {
+            return;
         }
 
-        VkDeviceSize bufferSize = sizeof(SpriteData) * sprites.size();
+        GpuScope scope{ profiler, commandBuffer, "sprite upload" };
+        // The previous frame's cull and vertex shader reads must finish before the copy overwrites the SSBO.
+        spriteBufferBarrier(commandBuffer, spriteDataBuffer->getBuffer(),
+            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
 
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
-        device.createBuffer(
-            bufferSize,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            stagingBuffer,
-            stagingBufferMemory
-        );
+        vkCmdCopyBuffer(commandBuffer, spriteUploadRing->getBuffer(), spriteDataBuffer->getBuffer(),
+            static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+
+        spriteBufferBarrier(commandBuffer, spriteDataBuffer->getBuffer(),
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    }
+
+    void RenderSystem::moveSpriteRecords(VkCommandBuffer commandBuffer, const std::vector<SpriteMove>& moves) {
+        if (moves.empty()) {
+            return;
+        }
+
+        GpuScope scope{ profiler, commandBuffer, "sprite move" };
+        spriteBufferBarrier(commandBuffer, spriteDataBuffer->getBuffer(),
+            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+
+        // Sprites only ever move down, so in ascending destination order no copy reads a record an earlier one wrote.
+        // A destination that an earlier copy still has to read starts a new batch behind a barrier instead.
+        std::vector<VkBufferCopy> copyRegions;
+        std::unordered_set<uint32_t> pendingSources;
+        auto flush = [&]() {
+            vkCmdCopyBuffer(commandBuffer, spriteDataBuffer->getBuffer(), spriteDataBuffer->getBuffer(),
+                static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+            spriteBufferBarrier(commandBuffer, spriteDataBuffer->getBuffer(),
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+            copyRegions.clear();
+            pendingSources.clear();
+        };
+        for (const SpriteMove& move : moves) {
+            if (pendingSources.count(move.to) != 0) {
+                flush();
+            }
+            appendCopy(copyRegions, sizeof(SpriteData) * move.from, sizeof(SpriteData) * move.to, sizeof(SpriteData));
+            pendingSources.insert(move.from);
+        }
+        // The trailing barrier also orders the moves before uploads that overwrite a source.
+        flush();
+    }
+
+    void RenderSystem::uploadChangedSprites(VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::vector<SpriteRange>& dirtyRanges,
+        const std::vector<SpriteMove>& moves) {
+        auto* staging = static_cast<SpriteData*>(spriteUploadRing->getRegion(frameIndex));
+        VkDeviceSize regionOffset = spriteUploadRing->getRegionOffset(frameIndex);
+        std::vector<VkBufferCopy> copyRegions;
+        size_t stagedCount = 0;
+        size_t nextMove = 0;
+
+        // Only the flagged sprites themselves: their clean neighbours hold GPU-integrated translations, and so do
+        // sprites that removal moved, which moveSpriteRecords already copied into place.
+        for (const SpriteRange& range : dirtyRanges) {
+            for (uint32_t index = range.begin; index < range.end; index++) {
+                while (nextMove < moves.size() && moves[nextMove].to < index) {
+                    nextMove++;
+                }
+                if (nextMove < moves.size() && moves[nextMove].to == index) {
+                    continue;
+                }
+                packSprite(sprites, index, staging[stagedCount]);
+                appendCopy(copyRegions, regionOffset + sizeof(SpriteData) * stagedCount, sizeof(SpriteData) * index, sizeof(SpriteData));
+                uploadedBytes += sizeof(SpriteData);
+                stagedCount++;
+            }
+        }
+
+        if (copyRegions.empty()) {
+            return;
+        }
+
+        GpuScope scope{ profiler, commandBuffer, "sprite upload" };
+        spriteBufferBarrier(commandBuffer, spriteDataBuffer->getBuffer(),
+            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+        vkCmdCopyBuffer(commandBuffer, spriteUploadRing->getBuffer(), spriteDataBuffer->getBuffer(),
+            static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+    }
 
-        void* data;
-        vkMapMemory(device.device(), stagingBufferMemory, 0, bufferSize, 0, &data);
-        memcpy(data, spriteData.data(), static_cast<size_t>(bufferSize));
-        vkUnmapMemory(device.device(), stagingBufferMemory);
+    void RenderSystem::uploadSpriteDrawInfo(VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::vector<SpriteRange>& dirtyRanges) {
+        // Every index whose sprite changed is dirty, so diffing the mirror there keeps the per-mesh counts exact.
+        // Sprites that fell off the end were either removed or moved into a dirty hole.
+        while (spriteMeshIds.size() > sprites.size()) {
+            meshSpriteCounts[spriteMeshIds.back()]--;
+            spriteMeshIds.pop_back();
+        }
+        const uint32_t unassigned = UINT32_MAX;
+        spriteMeshIds.resize(sprites.size(), unassigned);
+
+        // Draw info is staged after this frame's sprite records in the same ring region.
+        VkDeviceSize regionOffset = spriteUploadRing->getRegionOffset(frameIndex) + getSpriteRecordSize() * spriteCapacity;
+        auto* staging = reinterpret_cast<SpriteDrawInfo*>(static_cast<char*>(spriteUploadRing->getRegion(frameIndex)) + getSpriteRecordSize() * spriteCapacity);
+        std::vector<VkBufferCopy> copyRegions;
+        size_t stagedCount = 0;
+
+        for (const SpriteRange& range : dirtyRanges) {
+            for (uint32_t index = range.begin; index < range.end; index++) {
+                SpriteDrawInfo info = packDrawInfo(sprites, index);
+                if (spriteMeshIds[index] != unassigned) {
+                    meshSpriteCounts[spriteMeshIds[index]]--;
+                }
+                meshSpriteCounts[info.meshId]++;
+                spriteMeshIds[index] = info.meshId;
+                staging[stagedCount + index - range.begin] = info;
+            }
+            VkDeviceSize size = sizeof(SpriteDrawInfo) * (range.end - range.begin);
+            appendCopy(copyRegions, regionOffset + sizeof(SpriteDrawInfo) * stagedCount, sizeof(SpriteDrawInfo) * range.begin, size);
+            uploadedBytes += size;
+            stagedCount += range.end - range.begin;
+        }
+
+        if (copyRegions.empty()) {
+            return;
+        }
+
+        spriteBufferBarrier(commandBuffer, spriteDrawBuffer->getBuffer(),
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+        vkCmdCopyBuffer(commandBuffer, spriteUploadRing->getBuffer(), spriteDrawBuffer->getBuffer(),
+            static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+        spriteBufferBarrier(commandBuffer, spriteDrawBuffer->getBuffer(),
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    }
 
-        device.copyBuffer(stagingBuffer, spriteDataBuffer->getBuffer(), bufferSize);
+    void RenderSystem::integrateOnGpu(VkCommandBuffer commandBuffer, float deltaTime) {
+        GpuScope scope{ profiler, commandBuffer, "sprite motion" };
+        // Covers both the uploads recorded above and the previous frame's cull and vertex reads of the SSBO.
+        spriteBufferBarrier(commandBuffer, spriteDataBuffer->getBuffer(),
+            VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+        motionPipeline->bind(commandBuffer);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, motionPipeline->getPipelineLayout(), 0, 1, &spriteDataDescriptorSet, 0, nullptr);
+
+        MotionPush push{};
+        push.deltaTime = deltaTime;
+        push.spriteCount = static_cast<uint32_t>(sprites.size());
+        vkCmdPushConstants(commandBuffer, motionPipeline->getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(MotionPush), &push);
+        motionPipeline->dispatch(commandBuffer, push.spriteCount);
+
+        spriteBufferBarrier(commandBuffer, spriteDataBuffer->getBuffer(),
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    }
 
-        vkDestroyBuffer(device.device(), stagingBuffer, nullptr);
-        vkFreeMemory(device.device(), stagingBufferMemory, nullptr);
+    void RenderSystem::cullSprites(VkCommandBuffer commandBuffer) {
+        GpuScope scope{ profiler, commandBuffer, "cull" };
+
+        // The previous frame's draw must be done with the visible list and indirect command before they are rebuilt.
+        spriteBufferBarrier(commandBuffer, drawCommandBuffer->getBuffer(),
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+        // Both command layouts keep instanceCount at byte 4, where cull.comp counts the survivors.
+        static_assert(offsetof(VkDrawIndexedIndirectCommand, instanceCount) == offsetof(VkDrawIndirectCommand, instanceCount),
+            "cull.comp writes instanceCount at the same offset for both draw paths");
+        if (spriteGeometry == SpriteGeometry::VertexPulling) {
+            VkDrawIndirectCommand drawCommand{};
+            drawCommand.vertexCount = 6;
+            drawCommand.instanceCount = 0;
+            drawCommand.firstVertex = 0;
+            drawCommand.firstInstance = 0;
+            vkCmdUpdateBuffer(commandBuffer, drawCommandBuffer->getBuffer(), 0, sizeof(drawCommand), &drawCommand);
+        }
+        else {
+            // One command per mesh; firstInstance is the prefix sum of sprite counts, so every mesh gets its own
+            // slice of the visible list and the cull pass only has to count survivors into it. Sorted, these only
+            // supply each mesh's range to the draw runs, or with one mesh the command itself.
+            MeshPool& meshes = device.getMeshPool();
+            if (meshes.meshCount() > 1 && !device.getEnabledFeatures().drawIndirectFirstInstance) {
+                throw std::runtime_error("drawing sprites with several models requires drawIndirectFirstInstance!");
+            }
+            // Drawn per mesh, a sorted list would come out model by model regardless of layer and depth.
+            if (meshes.meshCount() > 1 && spriteOrder == SpriteOrder::Sorted && !drawRuns) {
+                throw std::runtime_error("sorting sprites with several models requires drawIndirectCount and multiDrawIndirect!");
+            }
+            drawCommands.clear();
+            uint32_t firstInstance = 0;
+            for (uint32_t mesh = 0; mesh < meshes.meshCount(); mesh++) {
+                const MeshRange& range = meshes.getRange(mesh);
+                VkDrawIndexedIndirectCommand drawCommand{};
+                drawCommand.indexCount = range.indexCount;
+                drawCommand.instanceCount = 0;
+                drawCommand.firstIndex = range.firstIndex;
+                drawCommand.vertexOffset = range.vertexOffset;
+                drawCommand.firstInstance = firstInstance;
+                drawCommands.push_back(drawCommand);
+                firstInstance += meshSpriteCounts[mesh];
+            }
+            if (!drawCommands.empty()) {
+                vkCmdUpdateBuffer(commandBuffer, drawCommandBuffer->getBuffer(), 0,
+                    sizeof(VkDrawIndexedIndirectCommand) * drawCommands.size(), drawCommands.data());
+            }
+        }
+
+        spriteBufferBarrier(commandBuffer, drawCommandBuffer->getBuffer(),
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+        spriteBufferBarrier(commandBuffer, visibleIndexBuffer->getBuffer(),
+            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+        cullPipeline->bind(commandBuffer);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline->getPipelineLayout(), 0, 1, &spriteDataDescriptorSet, 0, nullptr);
+
+        VkExtent2D extent = window.getExtent();
+        float aspectRatio = static_cast<float>(extent.width) / extent.height;
+        CullPush push{};
+        push.viewBounds = glm::vec4(-aspectRatio, -1.0f, aspectRatio, 1.0f);
+        push.spriteCount = static_cast<uint32_t>(sprites.size());
+        push.groupByMesh = spriteGeometry == SpriteGeometry::Model ? 1 : 0;
+        push.sortSprites = spriteOrder == SpriteOrder::Sorted ? 1 : 0;
+        uint32_t meshCount = spriteGeometry == SpriteGeometry::Model ? device.getMeshPool().meshCount() : 1;
+        push.meshBits = 0;
+        while ((1u << push.meshBits) < meshCount) {
+            push.meshBits++;
+        }
+        vkCmdPushConstants(commandBuffer, cullPipeline->getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPush), &push);
+        cullPipeline->dispatch(commandBuffer, push.spriteCount);
+
+        if (spriteOrder == SpriteOrder::Sorted) {
+            sortVisibleSprites(commandBuffer, push.meshBits);
+        }
+
+        spriteBufferBarrier(commandBuffer, drawCommandBuffer->getBuffer(),
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+        spriteBufferBarrier(commandBuffer, visibleIndexBuffer->getBuffer(),
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    }
+
+    void RenderSystem::sortVisibleSprites(VkCommandBuffer commandBuffer, uint32_t meshBits) {
+        GpuScope scope{ profiler, commandBuffer, "sort" };
+        // The cull pass wrote a key and an identity index for every sprite; culled keys sort to the back.
+        spriteBufferBarrier(commandBuffer, sortKeyBuffer->getBuffer(),
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+        spriteBufferBarrier(commandBuffer, visibleIndexBuffer->getBuffer(),
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+        radixSort->record(commandBuffer, static_cast<uint32_t>(sprites.size()));
+
+        // The sort's closing barrier also covers the per-mesh commands the cull pass counted into.
+        if (drawRuns) {
+            drawRuns->record(commandBuffer, static_cast<uint32_t>(sprites.size()), meshBits);
+        }
     }
 }
\ No newline at end of file
@@ -3,38 +3,106 @@
 #include "device.hpp"
 #include "pipeline.hpp"
 #include "model.hpp"
+#include "buffer.hpp"
 #include "texture.hpp"
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <memory>
 #include "swapChain.hpp"
+#include "stagingRing.hpp"
+#include "computePipeline.hpp"
+#include "spriteData.hpp"
+#include "spriteKernels.hpp"
+#include "jobSystem.hpp"
+#include "gpuProfiler.hpp"
+#include "radixSort.hpp"
+#include "drawRuns.hpp"
 
 namespace vulkan {
 
-    struct SpriteData {
-        glm::vec2 translation;
-        glm::mat2 transform;
-        glm::vec3 color;
-        uint32_t textureId; // Change to uint32_t
-        glm::vec2 speed;
-        float padding;
+    struct MotionPush {
+        float deltaTime;
+        uint32_t spriteCount;
+    };
+
+    struct CullPush {
+        glm::vec4 viewBounds; // minX, minY, maxX, maxY
+        uint32_t spriteCount;
+        uint32_t groupByMesh; // 0 on the vertex-pulling path, which draws every sprite from one command
+        uint32_t sortSprites;
+        uint32_t meshBits;    // sort key bits below the depth that hold the mesh id
+    };
+
+    enum class SpriteMotion {
+        Cpu, // integrated on the host, the whole array is streamed every frame
+        Gpu  // integrated in place by sprite.comp, only spawned or edited sprites are uploaded
+    };
+
+    enum class SpriteFormat {
+        Full,   // SpriteData, 32 bytes; works with either motion path
+        Compact // CompactSpriteData, 16 bytes; drops speed, so only SpriteMotion::Cpu can drive it
+    };
+
+    enum class SpriteGeometry {
+        Model,        // triangle.vert reads each sprite's Model from the mesh pool; one multi-draw covers every model
+        VertexPulling // quad.vert builds the corners from gl_VertexIndex and ignores models; no vertex or index buffer is bound
+    };
+
+    enum class SpriteOrder {
+        Unsorted, // store order within each mesh, as the cull pass happens to emit it
+        Sorted    // by layer, then back to front, then mesh and texture; radix sorted on the GPU every frame
     };
 
     class RenderSystem {
     public:
-        RenderSystem(Device& device, Window& window, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout);
+        // Format, geometry and order are baked into the pipelines and buffers, so they are fixed for the system's lifetime.
+        // Sorted order holds across all sprites and models; several models are drawn as one command per run of equal mesh,
+        // which needs drawIndirectCount and multiDrawIndirect, and cullSprites throws without them.
+        // framesInFlight must be the renderer's, whose frame index selects the upload ring region.
+        RenderSystem(Device& device, Window& window, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout, uint32_t framesInFlight,
+            SpriteFormat spriteFormat = SpriteFormat::Full, SpriteGeometry spriteGeometry = SpriteGeometry::Model,
+            SpriteOrder spriteOrder = SpriteOrder::Unsorted);
         ~RenderSystem();
         RenderSystem(const RenderSystem&) = delete;
         RenderSystem& operator=(const RenderSystem&) = delete;
 
         void initialize();
         void renderSprites(VkCommandBuffer commandBuffer);
-        void updateSprites(float deltaTime);
+        // Records the sprite upload into the frame's command buffer; call before beginSwapChainRenderPass.
+        void updateSprites(VkCommandBuffer commandBuffer, uint32_t frameIndex, float deltaTime);
 
+        // With SpriteMotion::Gpu the GPU owns translation; sprites flagged through SpriteStore::markDirty
+        // are re-uploaded whole from the host arrays, and sprites that removal moved are copied on the GPU. With SpriteMotion::Cpu only dirty chunks holding a moving
+        // or flagged sprite are re-packed and uploaded, so edits to a static sprite must be flagged too.
+        // Throws for SpriteMotion::Gpu with SpriteFormat::Compact.
+        void setSpriteMotion(SpriteMotion motion);
+        SpriteMotion getSpriteMotion() const { return spriteMotion; }
+        SpriteFormat getSpriteFormat() const { return spriteFormat; }
+        SpriteGeometry getSpriteGeometry() const { return spriteGeometry; }
+        SpriteOrder getSpriteOrder() const { return spriteOrder; }
+        // Bytes per sprite in the SSBO and upload ring.
+        VkDeviceSize getSpriteRecordSize() const;
+        // Runs the CPU motion path chunk by chunk on the calling thread, for bit-exact regression runs.
+        void setDeterministicUpdates(bool enabled) { jobSystem->setDeterministic(enabled); }
+        // Bytes of sprite records and draw info copied to the GPU by the last updateSprites.
+        VkDeviceSize getUploadedBytes() const { return uploadedBytes; }
+        // Times the upload, motion, cull and draw passes; usually the renderer's profiler.
+        void setProfiler(GpuProfiler* profiler) { this->profiler = profiler; }
+
+        static constexpr size_t UPDATE_CHUNK_SIZE = 16384;
+        static_assert(UPDATE_CHUNK_SIZE % SpriteStore::DIRTY_CHUNK_SIZE == 0, "jobs must not split a dirty chunk");
 
     private:
         void createPipelineLayout();
         void createPipeline(VkRenderPass renderPass);
+        void streamChangedSprites(VkCommandBuffer commandBuffer, uint32_t frameIndex, float deltaTime, const std::vector<SpriteRange>& dirtyRanges);
+        void moveSpriteRecords(VkCommandBuffer commandBuffer, const std::vector<SpriteMove>& moves);
+        void uploadChangedSprites(VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::vector<SpriteRange>& dirtyRanges,
+            const std::vector<SpriteMove>& moves);
+        void uploadSpriteDrawInfo(VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::vector<SpriteRange>& dirtyRanges);
+        void sortVisibleSprites(VkCommandBuffer commandBuffer, uint32_t meshBits);
+        void integrateOnGpu(VkCommandBuffer commandBuffer, float deltaTime);
+        void cullSprites(VkCommandBuffer commandBuffer);
         void initializeSpriteData();
         void createTextureArrayDescriptorSet();
 
@@ -42,10 +110,36 @@ namespace vulkan {
         Window& window;
         VkPipelineLayout pipelineLayout;
         std::unique_ptr<Pipeline> pipeline;
+        std::unique_ptr<ComputePipeline> motionPipeline;
+        std::unique_ptr<ComputePipeline> cullPipeline;
+        std::unique_ptr<RadixSort> radixSort;
+        std::unique_ptr<DrawRuns> drawRuns; // sorted sprites with models, when the device can count draws
+        std::unique_ptr<JobSystem> jobSystem;
         std::unique_ptr<Buffer> spriteDataBuffer;
+        std::unique_ptr<StagingRing> spriteUploadRing;
+        std::unique_ptr<Buffer> visibleIndexBuffer;
+        std::unique_ptr<Buffer> drawCommandBuffer;
+        std::unique_ptr<Buffer> spriteDrawBuffer;
+        std::unique_ptr<Buffer> sortKeyBuffer;
         VkDescriptorSetLayout descriptorSetLayout;
-        VkDescriptorSet spriteDataDescriptorSet;
-        VkDescriptorSet textureArrayDescriptorSet;
+        VkDescriptorSet spriteDataDescriptorSet = VK_NULL_HANDLE;
         std::vector<std::string> texturePaths;
+        GpuProfiler* profiler = nullptr;
+
+        // Host mirror of the mesh ids in spriteDrawBuffer and the sprite count of each mesh, which sizes its slice
+        // of the visible list when the sprites are not sorted.
+        std::vector<uint32_t> spriteMeshIds;
+        std::vector<uint32_t> meshSpriteCounts;
+        std::vector<VkDrawIndexedIndirectCommand> drawCommands;
+        size_t spriteCapacity = 0;
+        uint32_t framesInFlight;
+        // One flag per SpriteStore dirty chunk, set when the CPU motion path re-packs it this frame.
+        std::vector<uint8_t> changedChunks;
+        VkDeviceSize uploadedBytes = 0;
+
+        SpriteFormat spriteFormat;
+        SpriteGeometry spriteGeometry;
+        SpriteOrder spriteOrder;
+        SpriteMotion spriteMotion = SpriteMotion::Gpu;
     };
 }
\ No newline at end of file
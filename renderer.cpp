@@ -1,11 +1,15 @@
 #include "renderer.hpp"
 #include "pipeline.hpp"
 #include "main.hpp"
+#include "cpuProfiler.hpp"
+#include "global.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <stdexcept>
 #include <iostream>
+#include <thread>
 
 double lastTime;
 double currentTime;
@@ -13,12 +17,19 @@ double deltaTime;
 
 namespace vulkan {
 
-    Renderer::Renderer(Window& window, Device& device) : window{ window }, device{ device } {
+    Renderer::Renderer(Window& window, Device& device) : Renderer{ window, device, frameSettings } {}
+
+    Renderer::Renderer(Window& window, Device& device, const FrameSettings& settings) : window{ window }, device{ device }, settings{ settings } {
         recreateSwapChain();
         createCommandBuffers();
+        profiler = std::make_unique<GpuProfiler>(device, settings.framesInFlight);
+        readback = std::make_unique<FrameReadback>(device, settings.framesInFlight);
     }
 
-    Renderer::~Renderer() { freeCommandBuffers(); }
+    Renderer::~Renderer() {
+        profiler->printStats();
+        freeCommandBuffers();
+    }
 
     void Renderer::recreateSwapChain() {
         auto extent = window.getExtent();
@@ -29,20 +40,16 @@ namespace vulkan {
         vkDeviceWaitIdle(device.device());
 
         if (swapChain == nullptr) {
-            swapChain = std::make_unique<SwapChain>(device, extent);
+            swapChain = std::make_unique<SwapChain>(device, extent, settings);
         }
         else {
             auto oldSwapChain = std::move(swapChain);
-            swapChain = std::make_unique<SwapChain>(device, extent, std::move(oldSwapChain));
-            if (swapChain->imageCount() != commandBuffers.size()) {
-                freeCommandBuffers();
-                createCommandBuffers();
-            }
+            swapChain = std::make_unique<SwapChain>(device, extent, settings, std::move(oldSwapChain));
         }
     }
 
     void Renderer::createCommandBuffers() {
-        commandBuffers.resize(swapChain->imageCount());
+        commandBuffers.resize(settings.framesInFlight);
 
         VkCommandBufferAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -60,8 +67,27 @@ namespace vulkan {
         commandBuffers.clear();
     }
 
+    void Renderer::waitForNextFrame() {
+        if (frameSlotReady) {
+            return;
+        }
+        if (settings.frameRateLimit > 0.0f) {
+            CPU_ZONE("frame limiter");
+            auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(1.0 / settings.frameRateLimit));
+            auto frameStart = std::max(nextFrameStart, std::chrono::steady_clock::now());
+            std::this_thread::sleep_until(frameStart);
+            // A late frame restarts the schedule instead of rushing the following ones to catch up.
+            nextFrameStart = frameStart + period;
+        }
+        swapChain->waitForFrameSlot();
+        frameSlotReady = true;
+    }
+
     VkCommandBuffer Renderer::beginFrame() {
         assert(!isFrameStarted && "Can't call beginFrame while already in progress");
+        waitForNextFrame();
+        frameSlotReady = false;
         auto result = swapChain->acquireNextImage(&currentImageIndex);
         if (result == VK_ERROR_OUT_OF_DATE_KHR) {
             recreateSwapChain();
@@ -73,6 +99,8 @@ namespace vulkan {
         }
 
         isFrameStarted = true;
+        readback->collect(getFrameIndex());
+        recordStart = CpuProfiler::isEnabled() ? CpuProfiler::now() : 0;
 
         auto commandBuffer = getCurrentCommandBuffer();
 
@@ -82,14 +110,22 @@ namespace vulkan {
         if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
             throw std::runtime_error("failed to begin recording command buffer!");
         }
+
+        // acquireNextImage waited for this frame slot's timeline value, so its previous timestamps are ready to read.
+        profiler->beginFrame(commandBuffer, getFrameIndex());
+        profiler->beginScope(commandBuffer, "frame");
         return commandBuffer;
     }
     void Renderer::endFrame() {
         assert(isFrameStarted && "Can't call end frame while frame is not in progress");
         auto commandBuffer = getCurrentCommandBuffer();
+        profiler->endScope(commandBuffer);
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
             throw std::runtime_error("failed to record command buffer!");
         }
+        if (recordStart != 0) {
+            CpuProfiler::record("record commands", recordStart, CpuProfiler::now());
+        }
 
         auto result = swapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
@@ -102,6 +138,20 @@ namespace vulkan {
         }
 
         isFrameStarted = false;
+        frameNumber++;
+    }
+
+    bool Renderer::requestCapture() {
+        if (!swapChain->supportsReadback()) {
+            return false;
+        }
+        captureRequested = true;
+        return true;
+    }
+
+    void Renderer::flushCaptures() {
+        vkDeviceWaitIdle(device.device());
+        readback->collectAll();
     }
     void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
         VkRenderPassBeginInfo renderPassInfo{};
@@ -117,6 +167,7 @@ namespace vulkan {
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
+        profiler->beginScope(commandBuffer, "render pass");
         vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
         VkViewport viewport{};
@@ -138,5 +189,12 @@ namespace vulkan {
         assert(isFrameStarted && "Can't call this function frame while frame is not in progress");
         assert(commandBuffer == getCurrentCommandBuffer() && "Can't end renderpass on a commandbuffer from a different frame");
         vkCmdEndRenderPass(commandBuffer);
+        profiler->endScope(commandBuffer);
+
+        if (captureRequested) {
+            readback->capture(commandBuffer, getFrameIndex(), frameNumber, swapChain->getImage(currentImageIndex),
+                swapChain->getFinalLayout(), swapChain->getSwapChainImageFormat(), swapChain->getSwapChainExtent());
+            captureRequested = false;
+        }
     }
 }
\ No newline at end of file
@@ -1,10 +1,13 @@
 #pragma once
 
 #include "device.hpp"
+#include "gpuProfiler.hpp"
+#include "frameReadback.hpp"
 #include "model.hpp"
 #include "swapChain.hpp"
 #include "window.hpp"
 
+#include <chrono>
 #include <memory>
 #include <vector>
 #include <cassert>
@@ -14,7 +17,9 @@ namespace vulkan {
     class Renderer {
     public:
 
+        // The first form uses the global frameSettings.
         Renderer(Window& window, Device& device);
+        Renderer(Window& window, Device& device, const FrameSettings& settings);
         ~Renderer();
 
         Renderer(const Renderer&) = delete;
@@ -22,12 +27,29 @@ namespace vulkan {
 
         VkRenderPass getSwapChainRenderPass() const { return swapChain->getRenderPass(); }
         bool isFrameInProgress() const { return isFrameStarted; }
+        GpuProfiler& getProfiler() { return *profiler; }
+        uint32_t getFramesInFlight() const { return settings.framesInFlight; }
+
+        // Copies the color attachment of the frame being recorded once its render pass ends. Returns false if the
+        // swap chain images cannot be read back. Captures arrive through takeCapturedFrames() a few frames later.
+        bool requestCapture();
+        std::vector<CapturedFrame> takeCapturedFrames() { return readback->takeFrames(); }
+        // Waits for the device and collects every outstanding capture, e.g. before shutting down a capture run.
+        void flushCaptures();
 
         VkCommandBuffer getCurrentCommandBuffer() const {
             assert(isFrameStarted && "cannot get command buffer when frame is not in progress!");
-            return commandBuffers[currentImageIndex];
+            return commandBuffers[swapChain->getCurrentFrame()];
+        }
+
+        uint32_t getFrameIndex() const {
+            assert(isFrameStarted && "cannot get frame index when frame is not in progress!");
+            return swapChain->getCurrentFrame();
         }
 
+        // Paces to the frame rate limit, if any, and only then waits for the next frame slot, so the CPU blocks on
+        // the GPU as late as possible. Call it before polling input for the lowest latency; beginFrame calls it otherwise.
+        void waitForNextFrame();
         VkCommandBuffer beginFrame();
         void endFrame();
         void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
@@ -40,10 +62,18 @@ namespace vulkan {
 
         Window& window;
         Device& device;
+        FrameSettings settings;
         std::unique_ptr<SwapChain> swapChain;
-        std::vector<VkCommandBuffer> commandBuffers;
+        std::vector<VkCommandBuffer> commandBuffers; // one per frame slot, free again once the slot's timeline value is reached
+        std::unique_ptr<GpuProfiler> profiler;
+        std::unique_ptr<FrameReadback> readback;
+        bool captureRequested = false;
+        uint64_t frameNumber = 0;
+        std::chrono::steady_clock::time_point nextFrameStart{};
+        bool frameSlotReady = false;
 
         uint32_t currentImageIndex;
         bool isFrameStarted;
+        uint64_t recordStart = 0; // CpuProfiler::now() when recording began, 0 while tracing is off
     };
 }
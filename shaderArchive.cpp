@@ -0,0 +1,169 @@
+#include "shaderArchive.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <iostream>
+
+namespace vulkan {
+    static bool readWholeFile(const std::string& filepath, std::vector<char>& data) {
+        std::ifstream file{ filepath, std::ios::ate | std::ios::binary };
+        if (!file.is_open()) {
+            return false;
+        }
+        data.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(data.data(), data.size());
+        return static_cast<bool>(file);
+    }
+
+    template <typename T>
+    static bool readValue(const std::vector<char>& data, size_t& cursor, T& value) {
+        if (cursor + sizeof(T) > data.size()) {
+            return false;
+        }
+        memcpy(&value, data.data() + cursor, sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
+
+    template <typename T>
+    static void writeValue(std::ofstream& file, const T& value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    ShaderArchive::ShaderArchive(const std::string& archivePath) : archivePath{ archivePath } {}
+
+    uint64_t ShaderArchive::hashSource(const std::vector<char>& source) {
+        // FNV-1a; only needs to notice edits, not resist tampering.
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : source) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    bool ShaderArchive::load() {
+        entries.clear();
+        std::vector<char> data;
+        if (!readWholeFile(archivePath, data)) {
+            return false;
+        }
+
+        size_t cursor = 0;
+        uint32_t magic, version, entryCount;
+        if (!readValue(data, cursor, magic) || !readValue(data, cursor, version) || !readValue(data, cursor, entryCount) ||
+            magic != MAGIC || version != VERSION) {
+            std::cout << "Ignoring unrecognised shader archive " << archivePath << std::endl;
+            return false;
+        }
+
+        for (uint32_t i = 0; i < entryCount; i++) {
+            uint32_t nameLength;
+            uint64_t sourceHash, codeSize;
+            if (!readValue(data, cursor, nameLength) || cursor + nameLength > data.size()) {
+                entries.clear();
+                return false;
+            }
+            std::string name(data.data() + cursor, nameLength);
+            cursor += nameLength;
+            if (!readValue(data, cursor, sourceHash) || !readValue(data, cursor, codeSize) || cursor + codeSize > data.size()) {
+                entries.clear();
+                return false;
+            }
+            entries[name] = { sourceHash, std::vector<char>(data.begin() + cursor, data.begin() + cursor + codeSize) };
+            cursor += codeSize;
+        }
+        return true;
+    }
+
+    bool ShaderArchive::build(const std::vector<std::string>& sources) {
+        load();
+
+        size_t compiled = 0;
+        for (const auto& source : sources) {
+            std::string name = source + ".spv";
+            std::vector<char> text;
+            if (!readWholeFile(source, text)) {
+                if (contains(name)) {
+                    continue;
+                }
+                std::cerr << "Shader source " << source << " not found and not archived" << std::endl;
+                return false;
+            }
+
+            uint64_t hash = hashSource(text);
+            auto entry = entries.find(name);
+            if (entry != entries.end() && entry->second.sourceHash == hash) {
+                continue;
+            }
+
+            std::vector<char> code;
+            if (!compile(source, code)) {
+                return false;
+            }
+            entries[name] = { hash, std::move(code) };
+            compiled++;
+        }
+
+        std::cout << "Shader archive: " << entries.size() << " shaders, " << compiled << " recompiled" << std::endl;
+        return compiled == 0 || save();
+    }
+
+    bool ShaderArchive::compile(const std::string& source, std::vector<char>& code) const {
+        const char* compiler = std::getenv("GLSLC");
+        std::string output = source + ".spv";
+        std::string command = std::string(compiler ? compiler : "glslc") + " \"" + source + "\" -o \"" + output + "\"";
+
+        std::cout << "Compiling " << source << std::endl;
+        if (std::system(command.c_str()) != 0 || !readWholeFile(output, code)) {
+            std::cerr << "Failed to compile shader " << source << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool ShaderArchive::save() const {
+        std::string tempPath = archivePath + ".tmp";
+        {
+            std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+            writeValue(file, MAGIC);
+            writeValue(file, VERSION);
+            writeValue(file, static_cast<uint32_t>(entries.size()));
+            for (const auto& [name, entry] : entries) {
+                writeValue(file, static_cast<uint32_t>(name.size()));
+                file.write(name.data(), name.size());
+                writeValue(file, entry.sourceHash);
+                writeValue(file, static_cast<uint64_t>(entry.code.size()));
+                file.write(entry.code.data(), entry.code.size());
+            }
+            if (!file) {
+                std::cerr << "Failed to write shader archive " << tempPath << std::endl;
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, archivePath, error);
+        if (error) {
+            std::cerr << "Failed to replace shader archive " << archivePath << ": " << error.message() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<char> ShaderArchive::getCode(const std::string& name) const {
+        auto entry = entries.find(name);
+        if (entry != entries.end()) {
+            return entry->second.code;
+        }
+
+        std::vector<char> code;
+        if (!readWholeFile(name, code)) {
+            throw std::runtime_error("failed to open file: " + name);
+        }
+        return code;
+    }
+}
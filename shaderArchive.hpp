@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vulkan {
+    // All SPIR-V in one packed file, keyed by output name ("triangle.vert.spv") and tagged with the
+    // content hash of the GLSL it came from. The file is read once; only sources whose hash changed are recompiled.
+    class ShaderArchive {
+    public:
+        static constexpr uint32_t MAGIC = 0x41565053; // "SPVA"
+        static constexpr uint32_t VERSION = 1;
+
+        explicit ShaderArchive(const std::string& archivePath);
+
+        // Brings the archive up to date with the given GLSL sources and rewrites it if anything changed.
+        // Sources missing on disk keep their archived SPIR-V, so shipped builds need only the archive.
+        bool build(const std::vector<std::string>& sources);
+        bool load();
+
+        bool contains(const std::string& name) const { return entries.count(name) > 0; }
+        // Falls back to a loose .spv file for shaders that are not in the archive.
+        std::vector<char> getCode(const std::string& name) const;
+
+        static uint64_t hashSource(const std::vector<char>& source);
+
+    private:
+        struct Entry {
+            uint64_t sourceHash;
+            std::vector<char> code;
+        };
+
+        bool compile(const std::string& source, std::vector<char>& code) const;
+        bool save() const;
+
+        std::string archivePath;
+        std::unordered_map<std::string, Entry> entries;
+    };
+}
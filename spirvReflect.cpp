@@ -0,0 +1,190 @@
+#include "spirvReflect.hpp"
+#include <cstring>
+#include <stdexcept>
+
+namespace vulkan {
+    namespace spirv {
+        constexpr uint32_t MAGIC = 0x07230203;
+        constexpr uint32_t HEADER_WORDS = 5;
+
+        constexpr uint32_t OP_NAME = 5;
+        constexpr uint32_t OP_MEMBER_NAME = 6;
+        constexpr uint32_t OP_TYPE_ARRAY = 28;
+        constexpr uint32_t OP_TYPE_RUNTIME_ARRAY = 29;
+        constexpr uint32_t OP_TYPE_STRUCT = 30;
+        constexpr uint32_t OP_TYPE_POINTER = 32;
+        constexpr uint32_t OP_VARIABLE = 59;
+        constexpr uint32_t OP_DECORATE = 71;
+        constexpr uint32_t OP_MEMBER_DECORATE = 72;
+
+        constexpr uint32_t DECORATION_ARRAY_STRIDE = 6;
+        constexpr uint32_t DECORATION_BINDING = 33;
+        constexpr uint32_t DECORATION_DESCRIPTOR_SET = 34;
+        constexpr uint32_t DECORATION_OFFSET = 35;
+    }
+
+    // Literal strings are nul-terminated UTF-8 packed into the remaining words of the instruction.
+    static std::string readString(const uint32_t* words, size_t wordCount) {
+        const char* chars = reinterpret_cast<const char*>(words);
+        return std::string(chars, strnlen(chars, wordCount * sizeof(uint32_t)));
+    }
+
+    static BlockMember& memberAt(std::vector<BlockMember>& members, uint32_t index) {
+        if (members.size() <= index) {
+            members.resize(index + 1, BlockMember{ "", 0 });
+        }
+        return members[index];
+    }
+
+    SpirvReflection::SpirvReflection(const std::vector<char>& code) {
+        if (code.size() < spirv::HEADER_WORDS * sizeof(uint32_t) || code.size() % sizeof(uint32_t) != 0) {
+            throw std::runtime_error("SPIR-V module is truncated!");
+        }
+        std::vector<uint32_t> words(code.size() / sizeof(uint32_t));
+        memcpy(words.data(), code.data(), code.size());
+        if (words[0] != spirv::MAGIC) {
+            throw std::runtime_error("not a SPIR-V module!");
+        }
+
+        size_t position = spirv::HEADER_WORDS;
+        while (position < words.size()) {
+            const uint32_t* op = &words[position];
+            uint32_t wordCount = op[0] >> 16;
+            uint32_t opcode = op[0] & 0xffff;
+            if (wordCount == 0 || position + wordCount > words.size()) {
+                throw std::runtime_error("malformed SPIR-V instruction!");
+            }
+
+            switch (opcode) {
+            case spirv::OP_NAME:
+                if (wordCount >= 3) {
+                    names[op[1]] = readString(op + 2, wordCount - 2);
+                }
+                break;
+            case spirv::OP_MEMBER_NAME:
+                if (wordCount >= 4) {
+                    memberAt(structMembers[op[1]], op[2]).name = readString(op + 3, wordCount - 3);
+                }
+                break;
+            case spirv::OP_MEMBER_DECORATE:
+                if (wordCount >= 5 && op[3] == spirv::DECORATION_OFFSET) {
+                    memberAt(structMembers[op[1]], op[2]).offset = op[4];
+                }
+                break;
+            case spirv::OP_DECORATE:
+                if (wordCount >= 4) {
+                    if (op[2] == spirv::DECORATION_DESCRIPTOR_SET) descriptorSets[op[1]] = op[3];
+                    else if (op[2] == spirv::DECORATION_BINDING) bindings[op[1]] = op[3];
+                    else if (op[2] == spirv::DECORATION_ARRAY_STRIDE) arrayStrides[op[1]] = op[3];
+                }
+                break;
+            case spirv::OP_TYPE_STRUCT:
+                types[op[1]] = { TypeKind::Struct, std::vector<uint32_t>(op + 2, op + wordCount) };
+                break;
+            case spirv::OP_TYPE_RUNTIME_ARRAY:
+                types[op[1]] = { TypeKind::RuntimeArray, { op[2] } };
+                break;
+            case spirv::OP_TYPE_ARRAY:
+                types[op[1]] = { TypeKind::Array, { op[2] } };
+                break;
+            case spirv::OP_TYPE_POINTER:
+                types[op[1]] = { TypeKind::Pointer, { op[3] } };
+                break;
+            case spirv::OP_VARIABLE:
+                variables.push_back({ op[2], op[1] });
+                break;
+            default:
+                break;
+            }
+            position += wordCount;
+        }
+    }
+
+    std::vector<StorageBlockLayout> SpirvReflection::findStorageBlocks(uint32_t set, uint32_t binding) const {
+        auto kindOf = [this](uint32_t id, TypeKind kind) -> const Type* {
+            auto it = types.find(id);
+            return it != types.end() && it->second.kind == kind ? &it->second : nullptr;
+        };
+
+        std::vector<StorageBlockLayout> blocks;
+        for (const auto& variable : variables) {
+            auto setIt = descriptorSets.find(variable.id);
+            auto bindingIt = bindings.find(variable.id);
+            if (setIt == descriptorSets.end() || bindingIt == bindings.end() || setIt->second != set || bindingIt->second != binding) {
+                continue;
+            }
+
+            StorageBlockLayout& layout = blocks.emplace_back();
+            const Type* pointer = kindOf(variable.type, TypeKind::Pointer);
+            const Type* block = pointer ? kindOf(pointer->operands[0], TypeKind::Struct) : nullptr;
+            if (!block || block->operands.size() != 1) {
+                continue;
+            }
+            uint32_t arrayType = block->operands[0];
+            const Type* array = kindOf(arrayType, TypeKind::RuntimeArray);
+            if (!array || !kindOf(array->operands[0], TypeKind::Struct)) {
+                continue;
+            }
+
+            uint32_t element = array->operands[0];
+            auto nameIt = names.find(element);
+            auto strideIt = arrayStrides.find(arrayType);
+            auto membersIt = structMembers.find(element);
+            layout.elementName = nameIt != names.end() ? nameIt->second : "";
+            layout.runtimeArrayOfStructs = true;
+            layout.arrayStride = strideIt != arrayStrides.end() ? strideIt->second : 0;
+            if (membersIt != structMembers.end()) {
+                layout.members = membersIt->second;
+            }
+            layout.members.resize(types.at(element).operands.size(), BlockMember{ "", 0 });
+        }
+        return blocks;
+    }
+
+    void validateStorageBlock(const std::vector<char>& code, const std::string& shaderName, uint32_t set, uint32_t binding,
+        const std::string& elementName, uint32_t stride, const std::vector<BlockMember>& expected, BlockRequirement requirement) {
+        std::vector<StorageBlockLayout> blocks = SpirvReflection{ code }.findStorageBlocks(set, binding);
+        std::string where = shaderName + " set " + std::to_string(set) + " binding " + std::to_string(binding);
+
+        // Aliased blocks are told apart by element name; a block of any other shape is always an error.
+        const StorageBlockLayout* match = nullptr;
+        for (const auto& block : blocks) {
+            if (!block.runtimeArrayOfStructs) {
+                throw std::runtime_error(where + " must be a single runtime array of structs inside one block!");
+            }
+            if (block.elementName == elementName) {
+                match = &block;
+            }
+        }
+        if (!match) {
+            if (requirement == BlockRequirement::IfPresent) {
+                return;
+            }
+            // A stripped module has no names to match, so it cannot prove the layout either.
+            throw std::runtime_error(where + " binds no block of " + elementName + (blocks.empty() ? "" : " (" +
+                std::to_string(blocks.size()) + " block(s) of other or unnamed types)") + "!");
+        }
+
+        const StorageBlockLayout& layout = *match;
+        where += " (" + elementName + ")";
+        if (layout.arrayStride != stride) {
+            throw std::runtime_error(where + " has a " + std::to_string(layout.arrayStride) + "-byte stride, C++ expects "
+                + std::to_string(stride) + "!");
+        }
+        if (layout.members.size() != expected.size()) {
+            throw std::runtime_error(where + " declares " + std::to_string(layout.members.size()) + " members, C++ expects "
+                + std::to_string(expected.size()) + "!");
+        }
+        for (size_t i = 0; i < expected.size(); i++) {
+            const BlockMember& actual = layout.members[i];
+            if (!actual.name.empty() && actual.name != expected[i].name) {
+                throw std::runtime_error(where + " member " + std::to_string(i) + " is '" + actual.name + "', C++ expects '"
+                    + expected[i].name + "'!");
+            }
+            if (actual.offset != expected[i].offset) {
+                throw std::runtime_error(where + " member '" + expected[i].name + "' is at offset " + std::to_string(actual.offset)
+                    + ", C++ expects " + std::to_string(expected[i].offset) + "!");
+            }
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vulkan {
+    // A struct member as laid out in memory, in declaration order.
+    struct BlockMember {
+        std::string name;
+        uint32_t offset;
+    };
+
+    struct StorageBlockLayout {
+        std::string elementName;            // T's name, empty if the module was stripped
+        bool runtimeArrayOfStructs = false; // the block is exactly `{ T items[]; }` with T a struct
+        uint32_t arrayStride = 0;
+        std::vector<BlockMember> members;   // T's members; names are empty if the module was stripped
+    };
+
+    // Reads just enough of a SPIR-V module (names, decorations, struct/array/pointer types and
+    // variables) to recover the explicit std430 layout of its storage blocks.
+    class SpirvReflection {
+    public:
+        explicit SpirvReflection(const std::vector<char>& code);
+
+        // Every variable bound at (set, binding); shaders may alias one buffer with several block types.
+        std::vector<StorageBlockLayout> findStorageBlocks(uint32_t set, uint32_t binding) const;
+
+    private:
+        enum class TypeKind { Struct, RuntimeArray, Array, Pointer };
+
+        struct Type {
+            TypeKind kind;
+            std::vector<uint32_t> operands; // member types, element type or pointee type
+        };
+
+        struct Variable {
+            uint32_t id;
+            uint32_t type;
+        };
+
+        std::unordered_map<uint32_t, Type> types;
+        std::unordered_map<uint32_t, std::string> names;
+        std::unordered_map<uint32_t, std::vector<BlockMember>> structMembers;
+        std::unordered_map<uint32_t, uint32_t> descriptorSets;
+        std::unordered_map<uint32_t, uint32_t> bindings;
+        std::unordered_map<uint32_t, uint32_t> arrayStrides;
+        std::vector<Variable> variables;
+    };
+
+    enum class BlockRequirement {
+        Required, // the shader must bind a block of this element type there
+        IfPresent // checked only if bound; for the other type of a buffer the shader aliases
+    };
+
+    // Throws if any block at (set, binding) is not a runtime array of structs, if the one whose element is named
+    // elementName differs in stride or member offsets, or if a required one is missing.
+    void validateStorageBlock(const std::vector<char>& code, const std::string& shaderName, uint32_t set, uint32_t binding,
+        const std::string& elementName, uint32_t stride, const std::vector<BlockMember>& expected,
+        BlockRequirement requirement = BlockRequirement::Required);
+}
@@ -5,10 +5,13 @@
 #include "texture.hpp"
 
 namespace vulkan {
+    // Spawn description for SpriteStore::add; the store keeps each attribute in its own array.
     struct Sprite {
         std::shared_ptr<Model> model;
-        Texture* texture;
+        Texture* texture = nullptr; // required; SpriteStore::add rejects a sprite without one
         glm::vec3 color;
+        uint32_t layer = 0;  // higher layers are drawn on top when the renderer sorts sprites
+        float depth = 0.0f;  // within a layer, in [0, 1]; farther (larger) sprites are drawn first
         struct Transform2dComponent {
             glm::vec2 translation{ 0.f, 0.f };
             glm::vec2 scale{ 1.f, 1.f };
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include "spirvReflect.hpp"
+
+namespace vulkan {
+    // Mirrors the std430 SpriteData struct in triangle.vert, sprite.comp and cull.comp.
+    // Sprites are axis-aligned, so a per-axis scale replaces the old diagonal mat2 and the colour is RGBA8.
+    struct SpriteData {
+        glm::vec2 translation;
+        glm::vec2 speed;
+        glm::vec2 scale;
+        uint32_t color;     // packUnorm4x8 order: r in the low byte; unpacked with unpackUnorm4x8
+        uint32_t textureId;
+    };
+
+    static_assert(offsetof(SpriteData, translation) == 0, "SpriteData.translation must be at std430 offset 0");
+    static_assert(offsetof(SpriteData, speed) == 8, "SpriteData.speed must be at std430 offset 8");
+    static_assert(offsetof(SpriteData, scale) == 16, "SpriteData.scale must be at std430 offset 16");
+    static_assert(offsetof(SpriteData, color) == 24, "SpriteData.color must be at std430 offset 24");
+    static_assert(offsetof(SpriteData, textureId) == 28, "SpriteData.textureId must be at std430 offset 28");
+    static_assert(sizeof(SpriteData) == 32, "SpriteData must match the 32-byte std430 array stride");
+
+    // Checked against each shader's reflected SpriteBuffer when the pipelines are created.
+    inline std::vector<BlockMember> spriteDataLayout() {
+        return {
+            { "translation", static_cast<uint32_t>(offsetof(SpriteData, translation)) },
+            { "speed", static_cast<uint32_t>(offsetof(SpriteData, speed)) },
+            { "scale", static_cast<uint32_t>(offsetof(SpriteData, scale)) },
+            { "color", static_cast<uint32_t>(offsetof(SpriteData, color)) },
+            { "textureId", static_cast<uint32_t>(offsetof(SpriteData, textureId)) }
+        };
+    }
+
+    // Draw-only encoding for the CPU motion path, a third of the original 48-byte record. Selected in triangle.vert
+    // and cull.comp with the COMPACT_SPRITES specialization constant. Half floats stay within about a pixel at
+    // 1080p across the [-2, 2] view range; the host keeps integrating in full precision.
+    struct CompactSpriteData {
+        uint32_t translation;     // packHalf2x16
+        uint32_t scale;           // packHalf2x16
+        uint32_t color;           // RGBA8, as SpriteData::color
+        uint32_t rotationTexture; // low 16 bits: rotation in 1/65536 turns; high 16 bits: texture index
+    };
+
+    static_assert(offsetof(CompactSpriteData, translation) == 0, "CompactSpriteData.translation must be at std430 offset 0");
+    static_assert(offsetof(CompactSpriteData, scale) == 4, "CompactSpriteData.scale must be at std430 offset 4");
+    static_assert(offsetof(CompactSpriteData, color) == 8, "CompactSpriteData.color must be at std430 offset 8");
+    static_assert(offsetof(CompactSpriteData, rotationTexture) == 12, "CompactSpriteData.rotationTexture must be at std430 offset 12");
+    static_assert(sizeof(CompactSpriteData) == 16, "CompactSpriteData must match the 16-byte std430 array stride");
+
+    inline std::vector<BlockMember> compactSpriteDataLayout() {
+        return {
+            { "translation", static_cast<uint32_t>(offsetof(CompactSpriteData, translation)) },
+            { "scale", static_cast<uint32_t>(offsetof(CompactSpriteData, scale)) },
+            { "color", static_cast<uint32_t>(offsetof(CompactSpriteData, color)) },
+            { "rotationTexture", static_cast<uint32_t>(offsetof(CompactSpriteData, rotationTexture)) }
+        };
+    }
+
+    // Per-sprite draw metadata read by cull.comp from its own buffer; only re-uploaded for dirty sprites.
+    struct SpriteDrawInfo {
+        uint32_t meshId;  // MeshPool id of the sprite's model
+        uint32_t sortKey; // spriteSortKey, used when the renderer sorts sprites
+    };
+
+    static_assert(offsetof(SpriteDrawInfo, meshId) == 0, "SpriteDrawInfo.meshId must be at std430 offset 0");
+    static_assert(offsetof(SpriteDrawInfo, sortKey) == 4, "SpriteDrawInfo.sortKey must be at std430 offset 4");
+    static_assert(sizeof(SpriteDrawInfo) == 8, "SpriteDrawInfo must match the 8-byte std430 array stride");
+
+    inline std::vector<BlockMember> spriteDrawInfoLayout() {
+        return {
+            { "meshId", static_cast<uint32_t>(offsetof(SpriteDrawInfo, meshId)) },
+            { "sortKey", static_cast<uint32_t>(offsetof(SpriteDrawInfo, sortKey)) }
+        };
+    }
+
+    // Ascending order is draw order: layer in the top 8 bits, then 12 bits of inverted depth so farther sprites
+    // come first, then the texture index so equal-depth sprites sample the same texture back to back. With several
+    // models the cull pass puts the mesh id in the high texture bits, so equal meshes also draw as one run.
+    inline uint32_t spriteSortKey(uint32_t layer, float depth, uint32_t textureId) {
+        float nearness = 1.0f - (depth < 1.0f ? (depth > 0.0f ? depth : 0.0f) : 1.0f);
+        uint32_t quantized = static_cast<uint32_t>(nearness * 4095.0f + 0.5f);
+        return (layer < 0xffu ? layer : 0xffu) << 24 | quantized << 12 | (textureId & 0xfffu);
+    }
+
+    // Same clamp-then-truncate steps as the SIMD packing kernels, so every path produces identical bytes.
+    inline uint32_t packColor(const glm::vec3& color) {
+        const float channels[4] = { color.r, color.g, color.b, 1.0f };
+        uint32_t packed = 0;
+        for (uint32_t channel = 0; channel < 4; channel++) {
+            float value = channels[channel] * 255.0f;
+            value = value + 0.5f;
+            value = value < 255.0f ? value : 255.0f;
+            value = value > 0.0f ? value : 0.0f;
+            packed |= static_cast<uint32_t>(value) << (8 * channel);
+        }
+        return packed;
+    }
+
+    // Wraps any angle in radians into one turn and quantizes it to 16 bits.
+    inline uint32_t packRotation(float radians) {
+        float turns = radians * (1.0f / 6.28318530718f);
+        turns -= std::floor(turns);
+        return static_cast<uint32_t>(turns * 65536.0f + 0.5f) & 0xffffu;
+    }
+
+    inline CompactSpriteData packCompactSprite(const glm::vec2& translation, const glm::vec2& scale, const glm::vec3& color,
+        float rotation, uint32_t textureId) {
+        CompactSpriteData data;
+        data.translation = glm::packHalf2x16(translation);
+        data.scale = glm::packHalf2x16(scale);
+        data.color = packColor(color);
+        data.rotationTexture = packRotation(rotation) | (textureId << 16);
+        return data;
+    }
+}
@@ -0,0 +1,363 @@
+#include "spriteKernels.hpp"
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+// The scalar kernel is the reference the SIMD ones are compared with, so no multiply and add may be fused into an FMA.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#elif defined(_MSC_VER)
+#pragma fp_contract(off)
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SPRITE_KERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SPRITE_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(SPRITE_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SPRITE_TARGET_SSE4 __attribute__((target("sse4.1")))
+#define SPRITE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SPRITE_TARGET_SSE4
+#define SPRITE_TARGET_AVX2
+#endif
+
+namespace vulkan {
+    static_assert(sizeof(SpriteData) == 8 * sizeof(float), "packing kernels write SpriteData as 8 four-byte words");
+    static_assert(sizeof(glm::vec2) == 2 * sizeof(float), "packing kernels read vec2 streams as float pairs");
+
+    SpriteStreams makeSpriteStreams(SpriteStore& store) {
+        return { store.positions(), store.velocities(), store.scales(), store.rotations(), store.colors(), store.textureIds() };
+    }
+
+    static void packScalar(const SpriteStreams& streams, size_t first, size_t count, float deltaTime, SpriteData* out) {
+        for (size_t i = 0; i < count; i++) {
+            size_t index = first + i;
+            glm::vec2 step = streams.velocities[index] * deltaTime;
+            streams.positions[index] += step;
+
+            SpriteData& data = out[i];
+            data.translation = streams.positions[index];
+            data.speed = streams.velocities[index];
+            data.scale = streams.scales[index];
+            data.color = packColor(streams.colors[index]);
+            data.textureId = streams.textureIds[index];
+        }
+    }
+
+#ifdef SPRITE_KERNELS_X86
+    static void cpuid(int info[4], int leaf, int subleaf) {
+#ifdef _MSC_VER
+        __cpuidex(info, leaf, subleaf);
+#else
+        unsigned int a, b, c, d;
+        __cpuid_count(leaf, subleaf, a, b, c, d);
+        info[0] = static_cast<int>(a);
+        info[1] = static_cast<int>(b);
+        info[2] = static_cast<int>(c);
+        info[3] = static_cast<int>(d);
+#endif
+    }
+
+    static unsigned long long xgetbv0() {
+#ifdef _MSC_VER
+        return _xgetbv(0);
+#else
+        unsigned int eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+    }
+
+    // Four colours as RGBA8, one per 32-bit lane. min/max take the second operand for NaN, like packColor.
+    SPRITE_TARGET_SSE4 static inline __m128i packColorsSse4(const glm::vec3* color) {
+        const __m128 scale = _mm_set1_ps(255.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 zero = _mm_setzero_ps();
+        __m128i channels[4];
+        for (size_t sprite = 0; sprite < 4; sprite++) {
+            __m128 rgba = _mm_setr_ps(color[sprite].r, color[sprite].g, color[sprite].b, 1.0f);
+            rgba = _mm_add_ps(_mm_mul_ps(rgba, scale), half);
+            rgba = _mm_max_ps(_mm_min_ps(rgba, scale), zero);
+            channels[sprite] = _mm_cvttps_epi32(rgba);
+        }
+        return _mm_packus_epi16(_mm_packus_epi32(channels[0], channels[1]), _mm_packus_epi32(channels[2], channels[3]));
+    }
+
+    // [color0 id0 color1 id1 color2 id2 color3 id3], ready to sit beside each sprite's scale.
+    SPRITE_TARGET_SSE4 static inline void loadColorIdsSse4(const glm::vec3* color, const uint32_t* textureId, __m128& low, __m128& high) {
+        __m128i colors = packColorsSse4(color);
+        __m128i ids = _mm_loadu_si128(reinterpret_cast<const __m128i*>(textureId));
+        low = _mm_castsi128_ps(_mm_unpacklo_epi32(colors, ids));
+        high = _mm_castsi128_ps(_mm_unpackhi_epi32(colors, ids));
+    }
+
+    SPRITE_TARGET_SSE4 static void packSse4(const SpriteStreams& streams, size_t first, size_t count, float deltaTime, SpriteData* out) {
+        const __m128 dt = _mm_set1_ps(deltaTime);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            float* position = &streams.positions[first + i].x;
+            const float* velocity = &streams.velocities[first + i].x;
+            const float* scale = &streams.scales[first + i].x;
+            __m128 colorIds[2];
+            loadColorIdsSse4(streams.colors + first + i, streams.textureIds + first + i, colorIds[0], colorIds[1]);
+
+            // Each 128-bit register holds two sprites; each record is two 128-bit stores.
+            for (size_t pair = 0; pair < 2; pair++) {
+                __m128 p = _mm_loadu_ps(position + pair * 4);
+                __m128 v = _mm_loadu_ps(velocity + pair * 4);
+                p = _mm_add_ps(p, _mm_mul_ps(v, dt));
+                _mm_storeu_ps(position + pair * 4, p);
+                __m128 s = _mm_loadu_ps(scale + pair * 4);
+
+                float* dst = reinterpret_cast<float*>(out + i + pair * 2);
+                _mm_storeu_ps(dst, _mm_movelh_ps(p, v));
+                _mm_storeu_ps(dst + 4, _mm_movelh_ps(s, colorIds[pair]));
+                _mm_storeu_ps(dst + 8, _mm_movehl_ps(v, p));
+                _mm_storeu_ps(dst + 12, _mm_movehl_ps(colorIds[pair], s));
+            }
+        }
+        packScalar(streams, first + i, count - i, deltaTime, out + i);
+    }
+
+    SPRITE_TARGET_AVX2 static void packAvx2(const SpriteStreams& streams, size_t first, size_t count, float deltaTime, SpriteData* out) {
+        const __m256 dt = _mm256_set1_ps(deltaTime);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            float* position = &streams.positions[first + i].x;
+            const float* velocity = &streams.velocities[first + i].x;
+            const float* scale = &streams.scales[first + i].x;
+
+            // Each 256-bit register holds four sprites.
+            __m256 p = _mm256_loadu_ps(position);
+            __m256 v = _mm256_loadu_ps(velocity);
+            p = _mm256_add_ps(p, _mm256_mul_ps(v, dt));
+            _mm256_storeu_ps(position, p);
+            __m256 s = _mm256_loadu_ps(scale);
+
+            __m128 colorIdsLow, colorIdsHigh;
+            loadColorIdsSse4(streams.colors + first + i, streams.textureIds + first + i, colorIdsLow, colorIdsHigh);
+            __m256 colorIds = _mm256_insertf128_ps(_mm256_castps128_ps256(colorIdsLow), colorIdsHigh, 1);
+
+            // Treat each sprite's 8-byte field as one double lane, then interleave into whole 32-byte records.
+            __m256d translationSpeedEven = _mm256_unpacklo_pd(_mm256_castps_pd(p), _mm256_castps_pd(v));
+            __m256d translationSpeedOdd = _mm256_unpackhi_pd(_mm256_castps_pd(p), _mm256_castps_pd(v));
+            __m256d scaleColorEven = _mm256_unpacklo_pd(_mm256_castps_pd(s), _mm256_castps_pd(colorIds));
+            __m256d scaleColorOdd = _mm256_unpackhi_pd(_mm256_castps_pd(s), _mm256_castps_pd(colorIds));
+
+            double* dst = reinterpret_cast<double*>(out + i);
+            _mm256_storeu_pd(dst, _mm256_permute2f128_pd(translationSpeedEven, scaleColorEven, 0x20));
+            _mm256_storeu_pd(dst + 4, _mm256_permute2f128_pd(translationSpeedOdd, scaleColorOdd, 0x20));
+            _mm256_storeu_pd(dst + 8, _mm256_permute2f128_pd(translationSpeedEven, scaleColorEven, 0x31));
+            _mm256_storeu_pd(dst + 12, _mm256_permute2f128_pd(translationSpeedOdd, scaleColorOdd, 0x31));
+        }
+        packScalar(streams, first + i, count - i, deltaTime, out + i);
+    }
+#endif
+
+#ifdef SPRITE_KERNELS_NEON
+    // Four colours as RGBA8, one per 32-bit lane. Compare-and-select keeps packColor's NaN handling.
+    static inline uint32x4_t packColorsNeon(const glm::vec3* color) {
+        const float32x4_t scale = vdupq_n_f32(255.0f);
+        const float32x4_t half = vdupq_n_f32(0.5f);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        uint16x4_t channels[4];
+        for (size_t sprite = 0; sprite < 4; sprite++) {
+            const float values[4] = { color[sprite].r, color[sprite].g, color[sprite].b, 1.0f };
+            float32x4_t rgba = vaddq_f32(vmulq_f32(vld1q_f32(values), scale), half);
+            rgba = vbslq_f32(vcltq_f32(rgba, scale), rgba, scale);
+            rgba = vbslq_f32(vcgtq_f32(rgba, zero), rgba, zero);
+            channels[sprite] = vmovn_u32(vcvtq_u32_f32(rgba));
+        }
+        uint8x8_t low = vmovn_u16(vcombine_u16(channels[0], channels[1]));
+        uint8x8_t high = vmovn_u16(vcombine_u16(channels[2], channels[3]));
+        return vreinterpretq_u32_u8(vcombine_u8(low, high));
+    }
+
+    static void packNeon(const SpriteStreams& streams, size_t first, size_t count, float deltaTime, SpriteData* out) {
+        const float32x4_t dt = vdupq_n_f32(deltaTime);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            float* position = &streams.positions[first + i].x;
+            const float* velocity = &streams.velocities[first + i].x;
+            const float* scale = &streams.scales[first + i].x;
+            uint32x4x2_t colorIds = vzipq_u32(packColorsNeon(streams.colors + first + i), vld1q_u32(streams.textureIds + first + i));
+
+            for (size_t pair = 0; pair < 2; pair++) {
+                float32x4_t p = vld1q_f32(position + pair * 4);
+                float32x4_t v = vld1q_f32(velocity + pair * 4);
+                p = vaddq_f32(p, vmulq_f32(v, dt));
+                vst1q_f32(position + pair * 4, p);
+                float32x4_t s = vld1q_f32(scale + pair * 4);
+                float32x4_t colorId = vreinterpretq_f32_u32(colorIds.val[pair]);
+
+                float* dst = reinterpret_cast<float*>(out + i + pair * 2);
+                vst1q_f32(dst, vcombine_f32(vget_low_f32(p), vget_low_f32(v)));
+                vst1q_f32(dst + 4, vcombine_f32(vget_low_f32(s), vget_low_f32(colorId)));
+                vst1q_f32(dst + 8, vcombine_f32(vget_high_f32(p), vget_high_f32(v)));
+                vst1q_f32(dst + 12, vcombine_f32(vget_high_f32(s), vget_high_f32(colorId)));
+            }
+        }
+        packScalar(streams, first + i, count - i, deltaTime, out + i);
+    }
+#endif
+
+    static bool isSupported(SpriteKernel kernel) {
+        switch (kernel) {
+        case SpriteKernel::Scalar:
+            return true;
+#ifdef SPRITE_KERNELS_X86
+        case SpriteKernel::Sse4: {
+            int info[4];
+            cpuid(info, 1, 0);
+            return (info[2] & (1 << 19)) != 0;
+        }
+        case SpriteKernel::Avx2: {
+            int info[4];
+            cpuid(info, 0, 0);
+            if (info[0] < 7) {
+                return false;
+            }
+            cpuid(info, 1, 0);
+            bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (xgetbv0() & 0x6) == 0x6;
+            cpuid(info, 7, 0);
+            return osSavesYmm && (info[1] & (1 << 5)) != 0;
+        }
+#endif
+#ifdef SPRITE_KERNELS_NEON
+        case SpriteKernel::Neon:
+            return true;
+#endif
+        default:
+            return false;
+        }
+    }
+
+    SpriteKernel detectSpriteKernel() {
+        for (SpriteKernel kernel : { SpriteKernel::Avx2, SpriteKernel::Neon, SpriteKernel::Sse4 }) {
+            if (isSupported(kernel)) {
+                return kernel;
+            }
+        }
+        return SpriteKernel::Scalar;
+    }
+
+    static SpriteKernel& selectedKernel() {
+        static SpriteKernel kernel = detectSpriteKernel();
+        return kernel;
+    }
+
+    SpriteKernel activeSpriteKernel() {
+        return selectedKernel();
+    }
+
+    void forceSpriteKernel(SpriteKernel kernel) {
+        if (!isSupported(kernel)) {
+            throw std::runtime_error(std::string("sprite kernel not supported on this CPU: ") + spriteKernelName(kernel));
+        }
+        selectedKernel() = kernel;
+    }
+
+    const char* spriteKernelName(SpriteKernel kernel) {
+        switch (kernel) {
+        case SpriteKernel::Scalar: return "scalar";
+        case SpriteKernel::Sse4: return "sse4.1";
+        case SpriteKernel::Avx2: return "avx2";
+        case SpriteKernel::Neon: return "neon";
+        }
+        return "unknown";
+    }
+
+    static void packWith(SpriteKernel kernel, const SpriteStreams& streams, size_t first, size_t count, float deltaTime, SpriteData* out) {
+        switch (kernel) {
+#ifdef SPRITE_KERNELS_X86
+        case SpriteKernel::Avx2:
+            packAvx2(streams, first, count, deltaTime, out);
+            return;
+        case SpriteKernel::Sse4:
+            packSse4(streams, first, count, deltaTime, out);
+            return;
+#endif
+#ifdef SPRITE_KERNELS_NEON
+        case SpriteKernel::Neon:
+            packNeon(streams, first, count, deltaTime, out);
+            return;
+#endif
+        default:
+            packScalar(streams, first, count, deltaTime, out);
+            return;
+        }
+    }
+
+    void integrateAndPackSprites(const SpriteStreams& streams, size_t first, size_t count, float deltaTime, SpriteData* out) {
+        packWith(selectedKernel(), streams, first, count, deltaTime, out);
+    }
+
+    std::vector<SpriteKernelCheck> compareSpriteKernels(size_t spriteCount) {
+        std::mt19937 random{ 20240607u };
+        std::uniform_real_distribution<float> unit{ -1.0f, 1.0f };
+        std::vector<glm::vec2> startPositions(spriteCount), velocities(spriteCount), scales(spriteCount);
+        std::vector<float> rotations(spriteCount);
+        std::vector<glm::vec3> colors(spriteCount);
+        std::vector<uint32_t> textureIds(spriteCount);
+        for (size_t i = 0; i < spriteCount; i++) {
+            startPositions[i] = { unit(random), unit(random) };
+            velocities[i] = { 0.5f * unit(random), 0.5f * unit(random) };
+            scales[i] = { 0.55f + 0.45f * unit(random), 0.55f + 0.45f * unit(random) };
+            rotations[i] = unit(random);
+            // Slightly outside [0, 1] so the clamping in the colour packing is exercised too.
+            colors[i] = { 0.5f + 0.6f * unit(random), 0.5f + 0.6f * unit(random), 0.5f + 0.6f * unit(random) };
+            textureIds[i] = static_cast<uint32_t>(i % 4096);
+        }
+
+        std::vector<glm::vec2> referencePositions;
+        std::vector<SpriteData> reference(spriteCount);
+        std::vector<SpriteKernelCheck> checks;
+        for (SpriteKernel kernel : { SpriteKernel::Scalar, SpriteKernel::Sse4, SpriteKernel::Avx2, SpriteKernel::Neon }) {
+            if (!isSupported(kernel)) {
+                checks.push_back({ kernel, false, false });
+                continue;
+            }
+            std::vector<glm::vec2> positions = startPositions;
+            std::vector<SpriteData> packed(spriteCount);
+            SpriteStreams streams{ positions.data(), velocities.data(), scales.data(), rotations.data(), colors.data(), textureIds.data() };
+            packWith(kernel, streams, 0, spriteCount, 1.0f / 60.0f, packed.data());
+
+            if (kernel == SpriteKernel::Scalar) {
+                referencePositions = positions;
+                reference = packed;
+                checks.push_back({ kernel, true, true });
+                continue;
+            }
+            bool match = memcmp(packed.data(), reference.data(), sizeof(SpriteData) * spriteCount) == 0 &&
+                memcmp(positions.data(), referencePositions.data(), sizeof(glm::vec2) * spriteCount) == 0;
+            checks.push_back({ kernel, true, match });
+        }
+        return checks;
+    }
+
+    void integrateAndPackCompactSprites(const SpriteStreams& streams, size_t first, size_t count, float deltaTime, CompactSpriteData* out) {
+        for (size_t i = 0; i < count; i++) {
+            size_t index = first + i;
+            glm::vec2 step = streams.velocities[index] * deltaTime;
+            streams.positions[index] += step;
+            out[i] = packCompactSprite(streams.positions[index], streams.scales[index], streams.colors[index],
+                streams.rotations[index], streams.textureIds[index]);
+        }
+    }
+}
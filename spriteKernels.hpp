@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "spriteData.hpp"
+#include "spriteStore.hpp"
+
+namespace vulkan {
+    enum class SpriteKernel {
+        Scalar,
+        Sse4,
+        Avx2,
+        Neon
+    };
+
+    // Attribute arrays read by the packing kernels; positions are integrated in place.
+    struct SpriteStreams {
+        glm::vec2* positions;
+        const glm::vec2* velocities;
+        const glm::vec2* scales;
+        const float* rotations;
+        const glm::vec3* colors;
+        const uint32_t* textureIds;
+    };
+
+    SpriteStreams makeSpriteStreams(SpriteStore& store);
+
+    // Best kernel supported by this CPU; detected once on first use.
+    SpriteKernel detectSpriteKernel();
+    SpriteKernel activeSpriteKernel();
+    // Overrides the detected kernel, e.g. to compare paths against each other. Unsupported kernels throw.
+    void forceSpriteKernel(SpriteKernel kernel);
+    const char* spriteKernelName(SpriteKernel kernel);
+
+    struct SpriteKernelCheck {
+        SpriteKernel kernel;
+        bool supported;
+        bool matchesScalar; // every packed byte and integrated position equals the scalar kernel's
+    };
+
+    // Integrates and packs the same seeded sprites with every kernel and compares each with the scalar one, byte for byte.
+    // The count should not be a multiple of the 4-sprite SIMD block so the tails are covered too. Leaves the active kernel unchanged.
+    std::vector<SpriteKernelCheck> compareSpriteKernels(size_t spriteCount);
+
+    // Advances positions[first, first + count) by velocity * deltaTime and writes the matching records to out[0, count).
+    // Every kernel multiplies and adds separately (no FMA), so all paths produce bit-identical output.
+    void integrateAndPackSprites(const SpriteStreams& streams, size_t first, size_t count, float deltaTime, SpriteData* out);
+    // Same integration for the compact encoding. Scalar on every CPU: the half-float conversion dominates, not the stores.
+    void integrateAndPackCompactSprites(const SpriteStreams& streams, size_t first, size_t count, float deltaTime, CompactSpriteData* out);
+}
@@ -0,0 +1,217 @@
+#include "spriteStore.hpp"
+#include "texture.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace vulkan {
+    static uint32_t textureSlot(const Texture* texture) {
+        // Slot 0 is simply whichever texture registered first, so a missing texture would silently borrow it.
+        if (!texture) {
+            throw std::invalid_argument("sprite has no texture!");
+        }
+        if (texture->getSlot() == Texture::NO_SLOT) {
+            throw std::runtime_error("sprite texture is not in the bindless texture table!");
+        }
+        return texture->getSlot();
+    }
+
+    SpriteHandle SpriteStore::add(const Sprite& sprite) {
+        // Resolved first so a rejected sprite leaves the store untouched.
+        uint32_t textureId = textureSlot(sprite.texture);
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            slot = static_cast<uint32_t>(slotToDense.size());
+            slotToDense.push_back(0);
+            slotGenerations.push_back(0);
+        }
+
+        uint32_t index = static_cast<uint32_t>(size());
+        slotToDense[slot] = index;
+        denseToSlot.push_back(slot);
+
+        positions_.push_back(sprite.transform.translation);
+        velocities_.push_back(sprite.transform.speed);
+        scales_.push_back(sprite.transform.scale);
+        rotations_.push_back(sprite.transform.rotation);
+        colors_.push_back(sprite.color);
+        layers_.push_back(sprite.layer);
+        depths_.push_back(sprite.depth);
+        textures_.push_back(sprite.texture);
+        textureIds_.push_back(textureId);
+        models_.push_back(sprite.model.get());
+        markDirty(index);
+
+        return { slot, slotGenerations[slot] };
+    }
+
+    void SpriteStore::remove(SpriteHandle handle) {
+        size_t index = indexOf(handle);
+        size_t last = size() - 1;
+
+        if (index != last) {
+            positions_[index] = positions_[last];
+            velocities_[index] = velocities_[last];
+            scales_[index] = scales_[last];
+            rotations_[index] = rotations_[last];
+            colors_[index] = colors_[last];
+            layers_[index] = layers_[last];
+            depths_[index] = depths_[last];
+            textures_[index] = textures_[last];
+            textureIds_[index] = textureIds_[last];
+            models_[index] = models_[last];
+
+            uint32_t movedSlot = denseToSlot[last];
+            denseToSlot[index] = movedSlot;
+            slotToDense[movedSlot] = static_cast<uint32_t>(index);
+
+            // An edited or newly added sprite is repacked from the host anyway; any other one may only be current on the GPU.
+            auto moved = movedFrom_.find(static_cast<uint32_t>(last));
+            if (moved != movedFrom_.end() || !isDirty(last)) {
+                uint32_t from = moved != movedFrom_.end() ? moved->second : static_cast<uint32_t>(last);
+                movedFrom_[static_cast<uint32_t>(index)] = from;
+            }
+            else {
+                movedFrom_.erase(static_cast<uint32_t>(index));
+            }
+            markDirty(index);
+        }
+        // The last index no longer holds a sprite.
+        movedFrom_.erase(static_cast<uint32_t>(last));
+        clearDirty(last);
+
+        positions_.pop_back();
+        velocities_.pop_back();
+        scales_.pop_back();
+        rotations_.pop_back();
+        colors_.pop_back();
+        layers_.pop_back();
+        depths_.pop_back();
+        textures_.pop_back();
+        textureIds_.pop_back();
+        models_.pop_back();
+        denseToSlot.pop_back();
+
+        slotGenerations[handle.slot]++;
+        freeSlots.push_back(handle.slot);
+    }
+
+    void SpriteStore::clear() {
+        for (uint32_t slot : denseToSlot) {
+            slotGenerations[slot]++;
+            freeSlots.push_back(slot);
+        }
+        positions_.clear();
+        velocities_.clear();
+        scales_.clear();
+        rotations_.clear();
+        colors_.clear();
+        layers_.clear();
+        depths_.clear();
+        textures_.clear();
+        textureIds_.clear();
+        models_.clear();
+        denseToSlot.clear();
+        for (uint32_t chunk : dirtyChunks_) {
+            dirtyBits_[chunk] = 0;
+        }
+        dirtyChunks_.clear();
+        movedFrom_.clear();
+    }
+
+    void SpriteStore::reserve(size_t capacity) {
+        positions_.reserve(capacity);
+        velocities_.reserve(capacity);
+        scales_.reserve(capacity);
+        rotations_.reserve(capacity);
+        colors_.reserve(capacity);
+        layers_.reserve(capacity);
+        depths_.reserve(capacity);
+        textures_.reserve(capacity);
+        textureIds_.reserve(capacity);
+        models_.reserve(capacity);
+        denseToSlot.reserve(capacity);
+    }
+
+    bool SpriteStore::isValid(SpriteHandle handle) const {
+        return handle.slot < slotGenerations.size() && slotGenerations[handle.slot] == handle.generation;
+    }
+
+    size_t SpriteStore::indexOf(SpriteHandle handle) const {
+        if (!isValid(handle)) {
+            throw std::out_of_range("stale sprite handle!");
+        }
+        return slotToDense[handle.slot];
+    }
+
+    void SpriteStore::markDirty(SpriteHandle handle) {
+        size_t index = indexOf(handle);
+        // The host arrays now hold the sprite's truth, so a pending move would only be overwritten.
+        movedFrom_.erase(static_cast<uint32_t>(index));
+        markDirty(index);
+    }
+
+    void SpriteStore::markDirty(size_t index) {
+        size_t chunk = index / DIRTY_CHUNK_SIZE;
+        if (chunk >= dirtyBits_.size()) {
+            dirtyBits_.resize(chunk + 1, 0);
+        }
+        // A word is listed when it goes from zero to non-zero. clearDirty can zero a listed word, so a later mark
+        // may list it again; takeDirtyRanges drops the repeats.
+        if (dirtyBits_[chunk] == 0) {
+            dirtyChunks_.push_back(static_cast<uint32_t>(chunk));
+        }
+        dirtyBits_[chunk] |= uint64_t{ 1 } << (index % DIRTY_CHUNK_SIZE);
+    }
+
+    void SpriteStore::clearDirty(size_t index) {
+        size_t chunk = index / DIRTY_CHUNK_SIZE;
+        if (chunk < dirtyBits_.size()) {
+            // A word cleared to zero stays listed; takeDirtyRanges skips it.
+            dirtyBits_[chunk] &= ~(uint64_t{ 1 } << (index % DIRTY_CHUNK_SIZE));
+        }
+    }
+
+    bool SpriteStore::isDirty(size_t index) const {
+        size_t chunk = index / DIRTY_CHUNK_SIZE;
+        return chunk < dirtyBits_.size() && (dirtyBits_[chunk] >> (index % DIRTY_CHUNK_SIZE) & 1) != 0;
+    }
+
+    std::vector<SpriteRange> SpriteStore::takeDirtyRanges() {
+        std::vector<SpriteRange> ranges;
+        std::sort(dirtyChunks_.begin(), dirtyChunks_.end());
+        dirtyChunks_.erase(std::unique(dirtyChunks_.begin(), dirtyChunks_.end()), dirtyChunks_.end());
+        for (uint32_t chunk : dirtyChunks_) {
+            uint64_t bits = dirtyBits_[chunk];
+            dirtyBits_[chunk] = 0;
+            for (uint32_t bit = 0; bits != 0; bit++, bits >>= 1) {
+                if ((bits & 1) == 0) {
+                    continue;
+                }
+                uint32_t index = chunk * DIRTY_CHUNK_SIZE + bit;
+                if (!ranges.empty() && ranges.back().end == index) {
+                    ranges.back().end++;
+                }
+                else {
+                    ranges.push_back({ index, index + 1 });
+                }
+            }
+        }
+        dirtyChunks_.clear();
+        return ranges;
+    }
+
+    std::vector<SpriteMove> SpriteStore::takeMoves() {
+        std::vector<SpriteMove> moves;
+        moves.reserve(movedFrom_.size());
+        for (const auto& [to, from] : movedFrom_) {
+            moves.push_back({ from, to });
+        }
+        std::sort(moves.begin(), moves.end(), [](const SpriteMove& a, const SpriteMove& b) { return a.to < b.to; });
+        movedFrom_.clear();
+        return moves;
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "sprite.hpp"
+
+namespace vulkan {
+    // Stable reference to a sprite; stays valid while other sprites are added or removed.
+    struct SpriteHandle {
+        uint32_t slot = UINT32_MAX;
+        uint32_t generation = 0;
+    };
+
+    // Half-open run [begin, end) of dense sprite indices.
+    struct SpriteRange {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    // A clean sprite that removal moved from index `from` (as of the last takeMoves) to index `to`.
+    struct SpriteMove {
+        uint32_t from;
+        uint32_t to;
+    };
+
+    // Structure-of-arrays sprite storage. Live sprites are packed densely in [0, size()) so
+    // per-frame passes stream each attribute array linearly; removal swaps the last sprite into the hole.
+    class SpriteStore {
+    public:
+        // Sprites per dirty word; a clean word costs nothing when the renderer collects dirty ranges.
+        static constexpr uint32_t DIRTY_CHUNK_SIZE = 64;
+
+        SpriteHandle add(const Sprite& sprite);
+        void remove(SpriteHandle handle);
+        void clear();
+        void reserve(size_t capacity);
+
+        bool isValid(SpriteHandle handle) const;
+        size_t indexOf(SpriteHandle handle) const;
+        // Handle of the sprite currently at a dense index; goes stale once that sprite is removed.
+        SpriteHandle handleAt(size_t index) const { return { denseToSlot[index], slotGenerations[denseToSlot[index]] }; }
+        size_t size() const { return positions_.size(); }
+        bool empty() const { return positions_.empty(); }
+
+        // Flags a sprite whose attributes were edited so the renderer re-uploads it.
+        void markDirty(SpriteHandle handle);
+        // Every flagged sprite as ascending, maximally coalesced runs; clears the flags.
+        std::vector<SpriteRange> takeDirtyRanges();
+        // Unedited sprites that removal moved into a hole, ascending by destination. Their destinations are also
+        // flagged dirty, but a renderer whose GPU copy is newer than the host arrays should move the record instead
+        // of repacking it. A sprite moved twice is reported once, from where it was at the previous call.
+        std::vector<SpriteMove> takeMoves();
+
+        glm::vec2* positions() { return positions_.data(); }
+        glm::vec2* velocities() { return velocities_.data(); }
+        glm::vec2* scales() { return scales_.data(); }
+        float* rotations() { return rotations_.data(); }
+        glm::vec3* colors() { return colors_.data(); }
+        uint32_t* layers() { return layers_.data(); }
+        float* depths() { return depths_.data(); }
+        Texture** textures() { return textures_.data(); }
+        Model** models() { return models_.data(); }
+        // Bindless slot of each sprite's texture, cached so packing never chases the Texture pointer.
+        const uint32_t* textureIds() const { return textureIds_.data(); }
+        const glm::vec2* positions() const { return positions_.data(); }
+        const glm::vec2* velocities() const { return velocities_.data(); }
+        const glm::vec2* scales() const { return scales_.data(); }
+        const float* rotations() const { return rotations_.data(); }
+        const glm::vec3* colors() const { return colors_.data(); }
+        const uint32_t* layers() const { return layers_.data(); }
+        const float* depths() const { return depths_.data(); }
+        Texture* const* textures() const { return textures_.data(); }
+        Model* const* models() const { return models_.data(); }
+
+    private:
+        void markDirty(size_t index);
+        void clearDirty(size_t index);
+        bool isDirty(size_t index) const;
+
+        std::vector<glm::vec2> positions_;
+        std::vector<glm::vec2> velocities_;
+        std::vector<glm::vec2> scales_;
+        std::vector<float> rotations_;
+        std::vector<glm::vec3> colors_;
+        std::vector<uint32_t> layers_;
+        std::vector<float> depths_;
+        std::vector<Texture*> textures_;
+        std::vector<uint32_t> textureIds_;
+        std::vector<Model*> models_;
+
+        std::vector<uint32_t> denseToSlot;
+        std::vector<uint32_t> slotToDense;
+        std::vector<uint32_t> slotGenerations;
+        std::vector<uint32_t> freeSlots;
+        // One bit per sprite, DIRTY_CHUNK_SIZE sprites per word, plus the words that may have bits set.
+        std::vector<uint64_t> dirtyBits_;
+        std::vector<uint32_t> dirtyChunks_;
+        // Destination index to source index of each pending move.
+        std::unordered_map<uint32_t, uint32_t> movedFrom_;
+    };
+}
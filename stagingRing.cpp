@@ -0,0 +1,29 @@
+#include "stagingRing.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+
+namespace vulkan {
+    StagingRing::StagingRing(Device& device, VkDeviceSize regionSize, uint32_t regionCount)
+        : device{ device }, regionSize{ regionSize }, regionCount{ regionCount } {
+        VkDeviceSize alignment = std::max(
+            device.properties.limits.optimalBufferCopyOffsetAlignment,
+            device.properties.limits.nonCoherentAtomSize);
+        alignment = std::max<VkDeviceSize>(alignment, 4);
+        alignedRegionSize = (regionSize + alignment - 1) / alignment * alignment;
+
+        device.createBuffer(
+            alignedRegionSize * regionCount,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            buffer,
+            memory
+        );
+
+        std::cout << "Staging ring created: " << regionCount << " regions of " << alignedRegionSize << " bytes" << std::endl;
+    }
+
+    StagingRing::~StagingRing() {
+        device.destroyBuffer(buffer, memory);
+    }
+}
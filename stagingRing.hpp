@@ -0,0 +1,32 @@
+#pragma once
+
+#include "device.hpp"
+#include <vulkan/vulkan.h>
+
+namespace vulkan {
+
+    // Persistently mapped host-visible buffer split into one region per frame in flight.
+    // A region may only be rewritten once the frame that last used it has reached its timeline value.
+    class StagingRing {
+    public:
+        StagingRing(Device& device, VkDeviceSize regionSize, uint32_t regionCount);
+        ~StagingRing();
+
+        StagingRing(const StagingRing&) = delete;
+        StagingRing& operator=(const StagingRing&) = delete;
+
+        void* getRegion(uint32_t frameIndex) { return static_cast<char*>(memory.mapped) + getRegionOffset(frameIndex); }
+        VkDeviceSize getRegionOffset(uint32_t frameIndex) const { return alignedRegionSize * frameIndex; }
+        VkDeviceSize getRegionSize() const { return regionSize; }
+        uint32_t getRegionCount() const { return regionCount; }
+        VkBuffer getBuffer() const { return buffer; }
+
+    private:
+        Device& device;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        MemoryAllocation memory;
+        VkDeviceSize regionSize;
+        VkDeviceSize alignedRegionSize;
+        uint32_t regionCount;
+    };
+}
@@ -1,6 +1,8 @@
 #include "swapChain.hpp"
+#include "cpuProfiler.hpp"
 
 // std
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -11,17 +13,36 @@
 
 namespace vulkan {
 
-    SwapChain::SwapChain(Device& deviceRef, VkExtent2D extent) : device{ deviceRef }, windowExtent{ extent } {
+    static const char* presentModeName(VkPresentModeKHR mode) {
+        switch (mode) {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR: return "immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR: return "mailbox";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo relaxed";
+        default: return "fifo (v-sync)";
+        }
+    }
+
+    SwapChain::SwapChain(Device& deviceRef, VkExtent2D extent, const FrameSettings& settings)
+        : device{ deviceRef }, windowExtent{ extent }, settings{ settings } {
         init();
     }
 
-    SwapChain::SwapChain(Device& deviceRef, VkExtent2D extent, std::shared_ptr<SwapChain> previous) : device{ deviceRef }, windowExtent{ extent }, oldSwapChain{ previous } {
+    SwapChain::SwapChain(Device& deviceRef, VkExtent2D extent, const FrameSettings& settings, std::shared_ptr<SwapChain> previous)
+        : device{ deviceRef }, windowExtent{ extent }, settings{ settings }, oldSwapChain{ previous } {
         init();
         oldSwapChain = nullptr;
     }
 
     void SwapChain::init() {
-        createSwapChain();
+        if (settings.framesInFlight < 1 || settings.framesInFlight > MAX_FRAMES_IN_FLIGHT) {
+            throw std::runtime_error("frames in flight must be between 1 and " + std::to_string(MAX_FRAMES_IN_FLIGHT) + "!");
+        }
+        if (device.isHeadless()) {
+            createOffscreenImages();
+        }
+        else {
+            createSwapChain();
+        }
         createImageViews();
         createRenderPass();
         createDepthResources();
@@ -39,58 +60,58 @@ namespace vulkan {
             vkDestroySwapchainKHR(device.device(), swapChain, nullptr);
             swapChain = nullptr;
         }
+        for (size_t i = 0; i < offscreenImageMemorys.size(); i++) {
+            device.destroyImage(swapChainImages[i], offscreenImageMemorys[i]);
+        }
 
         for (int i = 0; i < depthImages.size(); i++) {
             vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-            vkDestroyImage(device.device(), depthImages[i], nullptr);
-            vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+            device.destroyImage(depthImages[i], depthImageMemorys[i]);
         }
 
         for (auto framebuffer : swapChainFramebuffers) { vkDestroyFramebuffer(device.device(), framebuffer, nullptr); }
 
         vkDestroyRenderPass(device.device(), renderPass, nullptr);
 
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-            vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
-            vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
-            vkDestroyFence(device.device(), inFlightFences[i], nullptr);
+        for (VkSemaphore semaphore : renderFinishedSemaphores) {
+            vkDestroySemaphore(device.device(), semaphore, nullptr);
+        }
+        for (VkSemaphore semaphore : imageAvailableSemaphores) {
+            vkDestroySemaphore(device.device(), semaphore, nullptr);
         }
     }
 
-    VkResult SwapChain::acquireNextImage(uint32_t* imageIndex) {
-        vkWaitForFences(device.device(), 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+    void SwapChain::waitForFrameSlot() {
+        CPU_ZONE("wait frame slot");
+        device.graphicsTimeline().wait(frameValues[currentFrame]);
+    }
 
+    VkResult SwapChain::acquireNextImage(uint32_t* imageIndex) {
+        CPU_ZONE("acquireNextImage");
+        // Returns at once if the frame limiter already waited for this slot.
+        waitForFrameSlot();
+
+        if (isHeadless()) {
+            // Offscreen image i is only ever rendered by frame slot i, so the wait above also frees it.
+            *imageIndex = static_cast<uint32_t>(currentFrame);
+            return VK_SUCCESS;
+        }
         return vkAcquireNextImageKHR(device.device(), swapChain, std::numeric_limits<uint64_t>::max(), imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, imageIndex);
     }
 
     VkResult SwapChain::submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) {
-        if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
-            vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
+        // No per-image wait: the command buffer belongs to the frame slot, which waitForFrameSlot already freed,
+        // and the acquire semaphore orders the image's reuse on the GPU.
+        std::vector<SemaphoreWait> waits;
+        VkSemaphore signalSemaphore = VK_NULL_HANDLE;
+        // Headless frames have no acquire or present to order against.
+        if (!isHeadless()) {
+            waits.push_back({ imageAvailableSemaphores[currentFrame], 0, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT });
+            signalSemaphore = renderFinishedSemaphores[*imageIndex];
         }
-        imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
+        frameValues[currentFrame] = device.graphicsTimeline().submit(buffers, 1, waits, signalSemaphore);
 
-        VkSubmitInfo submitInfo = {};
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-        VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
-        VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-        submitInfo.waitSemaphoreCount = 1;
-        submitInfo.pWaitSemaphores = waitSemaphores;
-        submitInfo.pWaitDstStageMask = waitStages;
-
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = buffers;
-
-        VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores = signalSemaphores;
-
-        vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-        VkResult result = vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]);
-        if (result != VK_SUCCESS) {
-            std::cerr << "Failed to submit draw command buffer! VkResult: " << result << std::endl;
-            throw std::runtime_error("failed to submit draw command buffer!");
-        }
+        VkSemaphore signalSemaphores[] = { signalSemaphore };
 
         VkPresentInfoKHR presentInfo = {};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -102,8 +123,12 @@ namespace vulkan {
         presentInfo.pSwapchains = swapChains;
         presentInfo.pImageIndices = imageIndex;
 
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        currentFrame = (currentFrame + 1) % settings.framesInFlight;
+        if (isHeadless()) {
+            return VK_SUCCESS;
+        }
 
+        CPU_ZONE("present");
         return vkQueuePresentKHR(device.presentQueue(), &presentInfo);
     }
 
@@ -111,7 +136,7 @@ namespace vulkan {
         SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
         VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-        VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+        presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
         VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
         uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
@@ -130,6 +155,10 @@ namespace vulkan {
         createInfo.imageExtent = extent;
         createInfo.imageArrayLayers = 1;
         createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        readbackSupported = (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+        if (readbackSupported) {
+            createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
 
         QueueFamilyIndices indices = device.findPhysicalQueueFamilies();
         uint32_t queueFamilyIndices[] = { indices.graphicsFamily, indices.presentFamily };
@@ -165,6 +194,36 @@ namespace vulkan {
         swapChainExtent = extent;
     }
 
+    void SwapChain::createOffscreenImages() {
+        // RGBA rather than the usual BGRA surface format, so readbacks are already in file order.
+        swapChainImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+        swapChainExtent = windowExtent;
+        readbackSupported = true;
+
+        swapChainImages.resize(settings.framesInFlight);
+        offscreenImageMemorys.resize(settings.framesInFlight);
+        for (size_t i = 0; i < swapChainImages.size(); i++) {
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent.width = swapChainExtent.width;
+            imageInfo.extent.height = swapChainExtent.height;
+            imageInfo.extent.depth = 1;
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = swapChainImageFormat;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, swapChainImages[i], offscreenImageMemorys[i]);
+        }
+        std::cout << "Headless: rendering to " << swapChainImages.size() << " offscreen images of "
+            << swapChainExtent.width << "x" << swapChainExtent.height << std::endl;
+    }
+
     void SwapChain::createImageViews() {
         swapChainImageViews.resize(swapChainImages.size());
         for (size_t i = 0; i < swapChainImages.size(); i++) {
@@ -209,7 +268,8 @@ namespace vulkan {
         colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        // Offscreen frames end ready to be copied out instead of presented.
+        colorAttachment.finalLayout = getFinalLayout();
 
         VkAttachmentReference colorAttachmentRef = {};
         colorAttachmentRef.attachment = 0;
@@ -230,6 +290,16 @@ namespace vulkan {
         dependency.srcAccessMask = 0;
         dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
 
+        // Makes the color writes, and the final layout transition, visible to a FrameReadback copy recorded after the pass.
+        VkSubpassDependency readbackDependency = {};
+        readbackDependency.srcSubpass = 0;
+        readbackDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        readbackDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        readbackDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+        readbackDependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        readbackDependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        std::array<VkSubpassDependency, 2> dependencies = { dependency, readbackDependency };
         std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
         VkRenderPassCreateInfo renderPassInfo = {};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -237,8 +307,8 @@ namespace vulkan {
         renderPassInfo.pAttachments = attachments.data();
         renderPassInfo.subpassCount = 1;
         renderPassInfo.pSubpasses = &subpass;
-        renderPassInfo.dependencyCount = 1;
-        renderPassInfo.pDependencies = &dependency;
+        renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        renderPassInfo.pDependencies = dependencies.data();
 
         if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
             throw std::runtime_error("failed to create render pass!");
@@ -317,24 +387,27 @@ namespace vulkan {
     }
 
     void SwapChain::createSyncObjects() {
-        imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-        imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+        // Value 0 is always reached, so a fresh slot never waits.
+        frameValues.assign(settings.framesInFlight, 0);
+        if (isHeadless()) {
+            return;
+        }
+
+        // A present may still be reading an image's semaphore after the frame slot comes round again,
+        // so the present semaphores are per image rather than per slot.
+        imageAvailableSemaphores.resize(settings.framesInFlight, VK_NULL_HANDLE);
+        renderFinishedSemaphores.resize(imageCount(), VK_NULL_HANDLE);
 
         VkSemaphoreCreateInfo semaphoreInfo = {};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-        VkFenceCreateInfo fenceInfo = {};
-        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-            if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
-                VK_SUCCESS ||
-                vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
-                VK_SUCCESS ||
-                vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+        for (auto& semaphore : imageAvailableSemaphores) {
+            if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create synchronization objects for a frame!");
+            }
+        }
+        for (auto& semaphore : renderFinishedSemaphores) {
+            if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
                 throw std::runtime_error("failed to create synchronization objects for a frame!");
             }
         }
@@ -354,14 +427,27 @@ namespace vulkan {
 
     VkPresentModeKHR SwapChain::chooseSwapPresentMode(
         const std::vector<VkPresentModeKHR>& availablePresentModes) {
-        for (const auto& availablePresentMode : availablePresentModes) {
-            if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-                return availablePresentMode;
-            }
+        std::vector<VkPresentModeKHR> preferred;
+        if (settings.presentPolicy == PresentPolicy::LowLatency) {
+            preferred = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+        }
+        else if (settings.presentPolicy == PresentPolicy::Relaxed) {
+            preferred = { VK_PRESENT_MODE_FIFO_RELAXED_KHR };
         }
 
-        std::cout << "Present mode: V-Sync" << std::endl;
-        return VK_PRESENT_MODE_FIFO_KHR;
+        // FIFO is the one mode every device must support.
+        VkPresentModeKHR chosen = VK_PRESENT_MODE_FIFO_KHR;
+        for (VkPresentModeKHR mode : preferred) {
+            if (std::find(availablePresentModes.begin(), availablePresentModes.end(), mode) != availablePresentModes.end()) {
+                chosen = mode;
+                break;
+            }
+        }
+        if (!preferred.empty() && chosen == VK_PRESENT_MODE_FIFO_KHR) {
+            std::cout << "Present mode: requested policy unsupported, falling back to fifo (v-sync)" << std::endl;
+        }
+        std::cout << "Present mode: " << presentModeName(chosen) << ", " << settings.framesInFlight << " frames in flight" << std::endl;
+        return chosen;
     }
 
     VkExtent2D SwapChain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) {
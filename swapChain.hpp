@@ -1,6 +1,7 @@
 #pragma once
 
 #include "device.hpp"
+#include "frameSettings.hpp"
 
 // vulkan headers
 #include <vulkan/vulkan.h>
@@ -14,10 +15,10 @@ namespace vulkan {
 
     class SwapChain {
     public:
-        static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+        static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
 
-        SwapChain(Device& deviceRef, VkExtent2D windowExtent);
-        SwapChain(Device& deviceRef, VkExtent2D windowExtent, std::shared_ptr<SwapChain> previous);
+        SwapChain(Device& deviceRef, VkExtent2D windowExtent, const FrameSettings& settings);
+        SwapChain(Device& deviceRef, VkExtent2D windowExtent, const FrameSettings& settings, std::shared_ptr<SwapChain> previous);
 
         ~SwapChain();
 
@@ -27,6 +28,10 @@ namespace vulkan {
         VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
         VkRenderPass getRenderPass() { return renderPass; }
         VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+        VkImage getImage(int index) { return swapChainImages[index]; }
+        // Layout the render pass leaves the color image in, and whether it may be copied from.
+        VkImageLayout getFinalLayout() const { return isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; }
+        bool supportsReadback() const { return readbackSupported; }
         size_t imageCount() { return swapChainImages.size(); }
         VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
         VkExtent2D getSwapChainExtent() { return swapChainExtent; }
@@ -38,6 +43,8 @@ namespace vulkan {
         }
         VkFormat findDepthFormat();
 
+        // Blocks until the frame slot about to be recorded is no longer in use by the GPU.
+        void waitForFrameSlot();
         VkResult acquireNextImage(uint32_t* imageIndex);
 
         bool compareSwapFormats(const SwapChain& swapChain) const {
@@ -47,10 +54,15 @@ namespace vulkan {
         VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
 
         VkSwapchainKHR getSwapChain() { return swapChain; }
+        bool isHeadless() const { return device.isHeadless(); }
+        uint32_t getCurrentFrame() const { return static_cast<uint32_t>(currentFrame); }
+        uint32_t getFramesInFlight() const { return settings.framesInFlight; }
+        VkPresentModeKHR getPresentMode() const { return presentMode; }
 
     private:
         void init();
         void createSwapChain();
+        void createOffscreenImages();
         void createImageViews();
         void createDepthResources();
         void createRenderPass();
@@ -72,21 +84,26 @@ namespace vulkan {
         VkRenderPass renderPass;
 
         std::vector<VkImage> depthImages;
-        std::vector<VkDeviceMemory> depthImageMemorys;
+        std::vector<MemoryAllocation> depthImageMemorys;
         std::vector<VkImageView> depthImageViews;
         std::vector<VkImage> swapChainImages;
+        std::vector<MemoryAllocation> offscreenImageMemorys; // headless only; swapchain images are owned by the driver
         std::vector<VkImageView> swapChainImageViews;
 
         Device& device;
         VkExtent2D windowExtent;
+        FrameSettings settings;
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
 
-        VkSwapchainKHR swapChain;
+        VkSwapchainKHR swapChain = VK_NULL_HANDLE;
+        bool readbackSupported = false;
         std::shared_ptr<SwapChain> oldSwapChain;
 
+        // Presentation only takes binary semaphores: one per frame slot for acquire, one per image for present.
         std::vector<VkSemaphore> imageAvailableSemaphores;
         std::vector<VkSemaphore> renderFinishedSemaphores;
-        std::vector<VkFence> inFlightFences;
-        std::vector<VkFence> imagesInFlight;
+        // Graphics timeline value each frame slot's last submit signals; the slot is free once it is reached.
+        std::vector<uint64_t> frameValues;
         size_t currentFrame = 0;
     };
 
@@ -1,17 +1,19 @@
 #include "texture.hpp"
-#include "pipeline.hpp"
+#include "device.hpp"
+#include "global.hpp"
+#include "uploadBatch.hpp"
 #include <stdexcept>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include <cstring>
 #include <iostream>
+#include <memory>
 
 namespace vulkan {
-    Texture::Texture(Device& device, const std::string& filepath, VkDescriptorSetLayout descriptorSetLayout,
-        VkDescriptorPool descriptorPool, Pipeline& pipeline)
-        : device(device), pipeline(pipeline), imageLayout(VK_IMAGE_LAYOUT_UNDEFINED),
-        image(VK_NULL_HANDLE), imageMemory(VK_NULL_HANDLE), imageView(VK_NULL_HANDLE),
-        sampler(VK_NULL_HANDLE), descriptorSet(VK_NULL_HANDLE), isArray(false), arrayLayers(1) {
+    Texture::Texture(Device& device, const std::string& filepath, UploadBatch* batch)
+        : device(device), imageLayout(VK_IMAGE_LAYOUT_UNDEFINED),
+        image(VK_NULL_HANDLE), imageView(VK_NULL_HANDLE),
+        sampler(VK_NULL_HANDLE), isArray(false), arrayLayers(1) {
         int texWidth, texHeight, texChannels;
         stbi_uc* pixels = stbi_load(filepath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
         if (!pixels) {
@@ -24,16 +26,13 @@ namespace vulkan {
         VkDeviceSize imageSize = texWidth * texHeight * 4;
         imageFormat = VK_FORMAT_R8G8B8A8_SRGB;
 
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
-        device.createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            stagingBuffer, stagingBufferMemory);
+        // Without a caller batch the texture still goes up in a single submit.
+        std::unique_ptr<UploadBatch> ownBatch;
+        UploadBatch& upload = batch ? *batch : *(ownBatch = std::make_unique<UploadBatch>(device));
 
-        void* data;
-        vkMapMemory(device.device(), stagingBufferMemory, 0, imageSize, 0, &data);
-        memcpy(data, pixels, static_cast<size_t>(imageSize));
-        vkUnmapMemory(device.device(), stagingBufferMemory);
+        VkBuffer stagingBuffer;
+        VkDeviceSize stagingOffset;
+        memcpy(upload.stage(imageSize, stagingBuffer, stagingOffset), pixels, static_cast<size_t>(imageSize));
 
         stbi_image_free(pixels);
 
@@ -54,13 +53,7 @@ namespace vulkan {
 
         device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory);
 
-        transitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-        device.copyBufferToImage(stagingBuffer, image, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1);
-
-        transitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-        vkDestroyBuffer(device.device(), stagingBuffer, nullptr);
-        vkFreeMemory(device.device(), stagingBufferMemory, nullptr);
+        recordUpload(upload, stagingBuffer, stagingOffset, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
 
         VkImageViewCreateInfo viewInfo{};
         viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -96,19 +89,29 @@ namespace vulkan {
             throw std::runtime_error("failed to create texture sampler!");
         }
 
-        createDescriptorSet(descriptorSetLayout, descriptorPool);
+        if (ownBatch) {
+            ownBatch->submitAndWait();
+        }
+        slot = textureRegistry.registerTexture(*this);
     }
 
-    Texture::Texture(Device& device, const std::vector<std::string>& filepaths, VkDescriptorSetLayout descriptorSetLayout,
-        VkDescriptorPool descriptorPool, Pipeline& pipeline)
-        : device(device), pipeline(pipeline), imageLayout(VK_IMAGE_LAYOUT_UNDEFINED),
-        image(VK_NULL_HANDLE), imageMemory(VK_NULL_HANDLE), imageView(VK_NULL_HANDLE),
-        sampler(VK_NULL_HANDLE), descriptorSet(VK_NULL_HANDLE), isArray(true) {
-        createTextureArray(filepaths);
-        createDescriptorSet(descriptorSetLayout, descriptorPool);
+    Texture::Texture(Device& device, const std::vector<std::string>& filepaths, UploadBatch* batch)
+        : device(device), imageLayout(VK_IMAGE_LAYOUT_UNDEFINED),
+        image(VK_NULL_HANDLE), imageView(VK_NULL_HANDLE),
+        sampler(VK_NULL_HANDLE), isArray(true) {
+        // Layered images need a sampler2DArray, so they stay out of the bindless sampler2D table.
+        std::unique_ptr<UploadBatch> ownBatch;
+        UploadBatch& upload = batch ? *batch : *(ownBatch = std::make_unique<UploadBatch>(device));
+        createTextureArray(filepaths, upload);
+        if (ownBatch) {
+            ownBatch->submitAndWait();
+        }
     }
 
     Texture::~Texture() {
+        if (slot != NO_SLOT) {
+            textureRegistry.unregisterTexture(slot);
+        }
         if (sampler != VK_NULL_HANDLE) {
             vkDestroySampler(device.device(), sampler, nullptr);
             sampler = VK_NULL_HANDLE;
@@ -118,17 +121,13 @@ namespace vulkan {
             imageView = VK_NULL_HANDLE;
         }
         if (image != VK_NULL_HANDLE) {
-            vkDestroyImage(device.device(), image, nullptr);
+            device.destroyImage(image, imageMemory);
             image = VK_NULL_HANDLE;
         }
-        if (imageMemory != VK_NULL_HANDLE) {
-            vkFreeMemory(device.device(), imageMemory, nullptr);
-            imageMemory = VK_NULL_HANDLE;
-        }
         std::cout << "Destroying Texture, VkDevice: " << device.device() << std::endl;
     }
 
-    void Texture::createTextureArray(const std::vector<std::string>& filepaths) {
+    void Texture::createTextureArray(const std::vector<std::string>& filepaths, UploadBatch& upload) {
         arrayLayers = static_cast<uint32_t>(filepaths.size());
         std::vector<stbi_uc*> pixelsArray(arrayLayers);
         int texWidth = 0, texHeight = 0, texChannels = 0;
@@ -154,19 +153,13 @@ namespace vulkan {
         imageFormat = VK_FORMAT_R8G8B8A8_SRGB;
 
         VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
-        device.createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            stagingBuffer, stagingBufferMemory);
-
-        void* data;
-        vkMapMemory(device.device(), stagingBufferMemory, 0, imageSize, 0, &data);
+        VkDeviceSize stagingOffset;
+        void* data = upload.stage(imageSize, stagingBuffer, stagingOffset);
         for (uint32_t i = 0; i < arrayLayers; ++i) {
             memcpy(static_cast<char*>(data) + i * texWidth * texHeight * 4, pixelsArray[i],
                 static_cast<size_t>(texWidth * texHeight * 4));
             stbi_image_free(pixelsArray[i]);
         }
-        vkUnmapMemory(device.device(), stagingBufferMemory);
 
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -185,13 +178,7 @@ namespace vulkan {
 
         device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory);
 
-        transitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-        device.copyBufferToImage(stagingBuffer, image, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), arrayLayers);
-
-        transitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-        vkDestroyBuffer(device.device(), stagingBuffer, nullptr);
-        vkFreeMemory(device.device(), stagingBufferMemory, nullptr);
+        recordUpload(upload, stagingBuffer, stagingOffset, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
 
         VkImageViewCreateInfo viewInfo{};
         viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -228,82 +215,10 @@ namespace vulkan {
         }
     }
 
-    void Texture::createDescriptorSet(VkDescriptorSetLayout descriptorSetLayout, VkDescriptorPool descriptorPool) {
-        VkDescriptorSetAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = descriptorPool;
-        allocInfo.descriptorSetCount = 1;
-        allocInfo.pSetLayouts = &descriptorSetLayout;
-
-        if (vkAllocateDescriptorSets(device.device(), &allocInfo, &descriptorSet) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate descriptor sets!");
-        }
-        std::cout << "Texture descriptor set allocated: " << descriptorSet << std::endl;
-
-        VkDescriptorImageInfo imageInfo{};
-        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo.imageView = imageView;
-        imageInfo.sampler = sampler;
-
-        VkWriteDescriptorSet descriptorWrite{};
-        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrite.dstSet = descriptorSet;
-        descriptorWrite.dstBinding = 1; // Matches fragment shader binding
-        descriptorWrite.dstArrayElement = 0;
-        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descriptorWrite.descriptorCount = 1;
-        descriptorWrite.pImageInfo = &imageInfo;
-
-        vkUpdateDescriptorSets(device.device(), 1, &descriptorWrite, 0, nullptr);
-    }
-
-    void Texture::transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout) {
-        VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
-
-        VkImageMemoryBarrier barrier{};
-        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.oldLayout = oldLayout;
-        barrier.newLayout = newLayout;
-        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.image = image;
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        barrier.subresourceRange.baseMipLevel = 0;
-        barrier.subresourceRange.levelCount = 1;
-        barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount = arrayLayers;
-
-        VkPipelineStageFlags sourceStage;
-        VkPipelineStageFlags destinationStage;
-
-        if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-            barrier.srcAccessMask = 0;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-            sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        }
-        else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-            sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-        }
-        else {
-            throw std::invalid_argument("unsupported layout transition!");
-        }
-
-        vkCmdPipelineBarrier(
-            commandBuffer,
-            sourceStage, destinationStage,
-            0,
-            0, nullptr,
-            0, nullptr,
-            1, &barrier
-        );
-
-        device.endSingleTimeCommands(commandBuffer);
-        imageLayout = newLayout;
+    void Texture::recordUpload(UploadBatch& upload, VkBuffer stagingBuffer, VkDeviceSize stagingOffset, uint32_t width, uint32_t height) {
+        upload.transitionImageLayout(image, arrayLayers, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        upload.copyBufferToImage(stagingBuffer, stagingOffset, image, width, height, arrayLayers);
+        upload.transitionImageLayout(image, arrayLayers, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     }
 }
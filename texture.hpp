@@ -1,41 +1,43 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include "memoryAllocator.hpp"
 #include <string>
 #include <vector>
+#include <cstdint>
 
 namespace vulkan {
     class Device;
-    class Pipeline;
+    class UploadBatch;
 
     class Texture {
     public:
-        Texture(Device& device, const std::string& filepath, VkDescriptorSetLayout descriptorSetLayout,
-            VkDescriptorPool descriptorPool, Pipeline& pipeline);
-        Texture(Device& device, const std::vector<std::string>& filepaths, VkDescriptorSetLayout descriptorSetLayout,
-            VkDescriptorPool descriptorPool, Pipeline& pipeline); // New: Texture array
+        // Pass a batch to record the upload alongside others; it must be submitted before the texture is sampled.
+        Texture(Device& device, const std::string& filepath, UploadBatch* batch = nullptr);
+        Texture(Device& device, const std::vector<std::string>& filepaths, UploadBatch* batch = nullptr); // New: Texture array
         ~Texture();
 
         Texture(const Texture&) = delete;
         Texture& operator=(const Texture&) = delete;
 
-        VkDescriptorSet getDescriptorSet() { return descriptorSet; }
+        // Index of this texture in the bindless sampler array (SpriteData.textureId).
+        uint32_t getSlot() const { return slot; }
+
+        static constexpr uint32_t NO_SLOT = UINT32_MAX;
         VkImageView getImageView() { return imageView; }
         VkSampler getSampler() { return sampler; }
         VkImageLayout getImageLayout() { return imageLayout; }
 
     private:
-        void createDescriptorSet(VkDescriptorSetLayout descriptorSetLayout, VkDescriptorPool descriptorPool);
-        void transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout);
-        void createTextureArray(const std::vector<std::string>& filepaths); // New: Texture array creation
+        void recordUpload(UploadBatch& upload, VkBuffer stagingBuffer, VkDeviceSize stagingOffset, uint32_t width, uint32_t height);
+        void createTextureArray(const std::vector<std::string>& filepaths, UploadBatch& upload); // New: Texture array creation
 
         Device& device;
-        Pipeline& pipeline;
         VkImageLayout imageLayout;
         VkImage image;
-        VkDeviceMemory imageMemory;
+        MemoryAllocation imageMemory;
         VkImageView imageView;
         VkSampler sampler;
-        VkDescriptorSet descriptorSet;
+        uint32_t slot{ NO_SLOT };
         VkFormat imageFormat;
         bool isArray{ false }; // Flag for texture array
         uint32_t arrayLayers{ 1 }; // Number of layers
@@ -0,0 +1,70 @@
+#include "textureRegistry.hpp"
+#include "device.hpp"
+#include "texture.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace vulkan {
+    uint32_t TextureRegistry::registerTexture(Texture& texture) {
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            if (slots.size() >= MAX_TEXTURES) {
+                throw std::runtime_error("bindless texture registry is full!");
+            }
+            slot = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+        }
+
+        slots[slot].imageView = texture.getImageView();
+        slots[slot].sampler = texture.getSampler();
+        for (auto& [descriptorSet, binding] : attachedSets) {
+            writeSlot(slot, descriptorSet, binding);
+        }
+        return slot;
+    }
+
+    void TextureRegistry::unregisterTexture(uint32_t slot) {
+        // The descriptor stays written but is never indexed again; partially-bound lets it go stale.
+        slots[slot] = Slot{};
+        freeSlots.push_back(slot);
+    }
+
+    void TextureRegistry::attach(Device& device, VkDescriptorSet descriptorSet, uint32_t binding) {
+        this->device = &device;
+        attachedSets.emplace_back(descriptorSet, binding);
+        for (uint32_t slot = 0; slot < slots.size(); slot++) {
+            if (slots[slot].imageView != VK_NULL_HANDLE) {
+                writeSlot(slot, descriptorSet, binding);
+            }
+        }
+    }
+
+    void TextureRegistry::detach(VkDescriptorSet descriptorSet) {
+        attachedSets.erase(
+            std::remove_if(attachedSets.begin(), attachedSets.end(),
+                [descriptorSet](const auto& attached) { return attached.first == descriptorSet; }),
+            attachedSets.end());
+    }
+
+    void TextureRegistry::writeSlot(uint32_t slot, VkDescriptorSet descriptorSet, uint32_t binding) {
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo.imageView = slots[slot].imageView;
+        imageInfo.sampler = slots[slot].sampler;
+
+        VkWriteDescriptorSet imageWrite{};
+        imageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        imageWrite.dstSet = descriptorSet;
+        imageWrite.dstBinding = binding;
+        imageWrite.dstArrayElement = slot;
+        imageWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        imageWrite.descriptorCount = 1;
+        imageWrite.pImageInfo = &imageInfo;
+
+        vkUpdateDescriptorSets(device->device(), 1, &imageWrite, 0, nullptr);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace vulkan {
+    class Device;
+    class Texture;
+
+    // Slot allocator for the bindless sampler array. Every attached descriptor set mirrors the live slots,
+    // so a sprite's textureId is just its texture's slot index.
+    class TextureRegistry {
+    public:
+        static constexpr uint32_t MAX_TEXTURES = 4096;
+
+        uint32_t registerTexture(Texture& texture);
+        void unregisterTexture(uint32_t slot);
+
+        // Writes every live slot into the set's variable-count binding and keeps it updated from then on.
+        void attach(Device& device, VkDescriptorSet descriptorSet, uint32_t binding);
+        void detach(VkDescriptorSet descriptorSet);
+
+        uint32_t textureCount() const { return static_cast<uint32_t>(slots.size() - freeSlots.size()); }
+
+    private:
+        struct Slot {
+            VkImageView imageView = VK_NULL_HANDLE;
+            VkSampler sampler = VK_NULL_HANDLE;
+        };
+
+        void writeSlot(uint32_t slot, VkDescriptorSet descriptorSet, uint32_t binding);
+
+        Device* device = nullptr;
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+        std::vector<std::pair<VkDescriptorSet, uint32_t>> attachedSets;
+    };
+}
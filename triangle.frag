@@ -7,8 +7,8 @@ layout(location = 2) flat in uint textureId;
 
 layout(location = 0) out vec4 outColor;
 
-layout(set = 0, binding = 1) uniform sampler2D texSampler[];
+layout(set = 0, binding = 5) uniform sampler2D texSampler[];
 
 void main() {
-    outColor = texture(texSampler[textureId], fragTexCoord);
+    outColor = texture(texSampler[nonuniformEXT(textureId)], fragTexCoord);
 }
\ No newline at end of file
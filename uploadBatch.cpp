@@ -0,0 +1,293 @@
+#include "uploadBatch.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <iostream>
+
+namespace vulkan {
+    UploadBatch::UploadBatch(Device& device, UploadQueue queue)
+        : device{ device }, useTransferQueue{ queue == UploadQueue::Transfer && device.hasDedicatedTransferQueue() } {
+        commandPool = useTransferQueue ? device.getTransferCommandPool() : device.getCommandPool();
+        stagingAlignment = std::max<VkDeviceSize>(device.properties.limits.optimalBufferCopyOffsetAlignment, 16);
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool;
+        allocInfo.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(device.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate upload command buffer!");
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    }
+
+    UploadBatch::~UploadBatch() {
+        // An unsubmitted batch is discarded; a submitted one must finish before its staging memory goes away.
+        if (submitted && !completed) {
+            wait();
+        }
+        releaseStaging();
+        freeCommandBuffers();
+    }
+
+    void* UploadBatch::stage(VkDeviceSize size, VkBuffer& buffer, VkDeviceSize& offset) {
+        if (submitted) {
+            throw std::runtime_error("upload batch already submitted!");
+        }
+
+        StagingChunk* chunk = stagingChunks.empty() ? nullptr : &stagingChunks.back();
+        VkDeviceSize alignedUsed = chunk ? (chunk->used + stagingAlignment - 1) / stagingAlignment * stagingAlignment : 0;
+        if (!chunk || alignedUsed + size > chunk->size) {
+            StagingChunk newChunk;
+            newChunk.size = std::max(size, STAGING_CHUNK_SIZE);
+            device.createBuffer(newChunk.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                newChunk.buffer, newChunk.memory);
+            stagingChunks.push_back(newChunk);
+            chunk = &stagingChunks.back();
+            alignedUsed = 0;
+        }
+
+        chunk->used = alignedUsed + size;
+        buffer = chunk->buffer;
+        offset = alignedUsed;
+        return static_cast<char*>(chunk->memory.mapped) + alignedUsed;
+    }
+
+    void UploadBatch::uploadToBuffer(VkBuffer dst, const void* data, VkDeviceSize size, VkDeviceSize dstOffset) {
+        VkBuffer stagingBuffer;
+        VkDeviceSize stagingOffset;
+        memcpy(stage(size, stagingBuffer, stagingOffset), data, static_cast<size_t>(size));
+        copyBuffer(stagingBuffer, dst, size, stagingOffset, dstOffset);
+    }
+
+    void UploadBatch::uploadToImage(VkImage image, const void* data, VkDeviceSize size, uint32_t width, uint32_t height, uint32_t layerCount) {
+        VkBuffer stagingBuffer;
+        VkDeviceSize stagingOffset;
+        memcpy(stage(size, stagingBuffer, stagingOffset), data, static_cast<size_t>(size));
+        copyBufferToImage(stagingBuffer, stagingOffset, image, width, height, layerCount);
+    }
+
+    void UploadBatch::copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset) {
+        if (submitted) {
+            throw std::runtime_error("upload batch already submitted!");
+        }
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = srcOffset;
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = size;
+        vkCmdCopyBuffer(commandBuffer, src, dst, 1, &copyRegion);
+        commandCount++;
+        copiedBuffers = true;
+
+        if (useTransferQueue) {
+            VkBufferMemoryBarrier transfer{};
+            transfer.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            transfer.srcQueueFamilyIndex = device.transferQueueFamily();
+            transfer.dstQueueFamilyIndex = device.graphicsQueueFamily();
+            transfer.buffer = dst;
+            transfer.offset = dstOffset;
+            transfer.size = size;
+            bufferTransfers.push_back(transfer);
+        }
+    }
+
+    void UploadBatch::copyBufferToImage(VkBuffer buffer, VkDeviceSize bufferOffset, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount) {
+        if (submitted) {
+            throw std::runtime_error("upload batch already submitted!");
+        }
+        VkBufferImageCopy region{};
+        region.bufferOffset = bufferOffset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = layerCount;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { width, height, 1 };
+        vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        commandCount++;
+    }
+
+    void UploadBatch::transitionImageLayout(VkImage image, uint32_t layerCount, VkImageLayout oldLayout, VkImageLayout newLayout) {
+        if (submitted) {
+            throw std::runtime_error("upload batch already submitted!");
+        }
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = layerCount;
+
+        VkPipelineStageFlags sourceStage;
+        VkPipelineStageFlags destinationStage;
+
+        if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+            sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        }
+        else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && useTransferQueue) {
+            // The copy queue can't name fragment-shader stages, so the layout change rides on the
+            // ownership release here and the matching acquire on the graphics queue.
+            barrier.srcQueueFamilyIndex = device.transferQueueFamily();
+            barrier.dstQueueFamilyIndex = device.graphicsQueueFamily();
+            imageTransfers.push_back(barrier);
+            return;
+        }
+        else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+            sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        }
+        else {
+            throw std::invalid_argument("unsupported layout transition!");
+        }
+
+        vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        commandCount++;
+    }
+
+    void UploadBatch::submit() {
+        if (submitted) {
+            throw std::runtime_error("upload batch already submitted!");
+        }
+
+        if (!useTransferQueue) {
+            // Barriers order work across submits on one queue, so this covers every later frame that reads the buffers.
+            if (copiedBuffers) {
+                VkMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+                vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                    1, &barrier, 0, nullptr, 0, nullptr);
+            }
+            vkEndCommandBuffer(commandBuffer);
+            timelineValue = device.graphicsTimeline().submit(&commandBuffer, 1);
+            submitted = true;
+            return;
+        }
+
+        recordOwnershipTransfer();
+
+        QueueTimeline& transfer = device.transferTimeline();
+        uint64_t transferValue = transfer.submit(&commandBuffer, 1);
+        timelineValue = device.graphicsTimeline().submit(&acquireCommandBuffer, 1,
+            { transfer.waitFor(transferValue, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT) });
+        submitted = true;
+    }
+
+    void UploadBatch::recordOwnershipTransfer() {
+        // Release: finish the transfer writes and hand the resources to the graphics family.
+        for (auto& barrier : bufferTransfers) {
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+        }
+        for (auto& barrier : imageTransfers) {
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+        }
+        if (!bufferTransfers.empty() || !imageTransfers.empty()) {
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                0, nullptr,
+                static_cast<uint32_t>(bufferTransfers.size()), bufferTransfers.data(),
+                static_cast<uint32_t>(imageTransfers.size()), imageTransfers.data());
+        }
+        vkEndCommandBuffer(commandBuffer);
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = device.getCommandPool();
+        allocInfo.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(device.device(), &allocInfo, &acquireCommandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate upload acquire command buffer!");
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(acquireCommandBuffer, &beginInfo);
+
+        // Acquire: the same barriers replayed on the graphics queue make the data visible to every later use.
+        for (auto& barrier : bufferTransfers) {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        }
+        for (auto& barrier : imageTransfers) {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        }
+        if (!bufferTransfers.empty() || !imageTransfers.empty()) {
+            vkCmdPipelineBarrier(acquireCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                0, nullptr,
+                static_cast<uint32_t>(bufferTransfers.size()), bufferTransfers.data(),
+                static_cast<uint32_t>(imageTransfers.size()), imageTransfers.data());
+        }
+        vkEndCommandBuffer(acquireCommandBuffer);
+    }
+
+    void UploadBatch::wait() {
+        if (!submitted) {
+            throw std::runtime_error("upload batch was never submitted!");
+        }
+        if (completed) {
+            return;
+        }
+        device.graphicsTimeline().wait(timelineValue);
+        completed = true;
+
+        freeCommandBuffers();
+        releaseStaging();
+    }
+
+    bool UploadBatch::isComplete() {
+        if (completed) {
+            return true;
+        }
+        if (submitted && device.graphicsTimeline().isComplete(timelineValue)) {
+            wait();
+            return true;
+        }
+        return false;
+    }
+
+    void UploadBatch::freeCommandBuffers() {
+        if (commandBuffer != VK_NULL_HANDLE) {
+            vkFreeCommandBuffers(device.device(), commandPool, 1, &commandBuffer);
+            commandBuffer = VK_NULL_HANDLE;
+        }
+        if (acquireCommandBuffer != VK_NULL_HANDLE) {
+            vkFreeCommandBuffers(device.device(), device.getCommandPool(), 1, &acquireCommandBuffer);
+            acquireCommandBuffer = VK_NULL_HANDLE;
+        }
+    }
+
+    void UploadBatch::releaseStaging() {
+        for (auto& chunk : stagingChunks) {
+            device.destroyBuffer(chunk.buffer, chunk.memory);
+        }
+        stagingChunks.clear();
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "device.hpp"
+#include "memoryAllocator.hpp"
+#include <vulkan/vulkan.h>
+#include <vector>
+
+namespace vulkan {
+    enum class UploadQueue {
+        Graphics,
+        Transfer
+    };
+
+    // Records any number of uploads, copies and layout transitions into one command buffer and submits them
+    // as one value on the device's graphics timeline. Staging memory is owned by the batch and released in wait().
+    // A Transfer batch runs on the dedicated copy queue when there is one: destinations are released to the
+    // graphics family at the end of the copy, and a small graphics submit waits on the transfer timeline to acquire them.
+    // Either way the batch ends with a barrier that makes its buffer writes visible to vertex input, vertex and compute
+    // shaders, so later graphics submits can read the data without anyone waiting on the host.
+    // Sources passed to copyBuffer must be staging memory or otherwise safe to read on that queue.
+    class UploadBatch {
+    public:
+        static constexpr VkDeviceSize STAGING_CHUNK_SIZE = 16ull * 1024 * 1024;
+
+        explicit UploadBatch(Device& device, UploadQueue queue = UploadQueue::Graphics);
+        ~UploadBatch();
+
+        UploadBatch(const UploadBatch&) = delete;
+        UploadBatch& operator=(const UploadBatch&) = delete;
+
+        // Copies data into batch-owned staging memory now and records the transfer into dst.
+        void uploadToBuffer(VkBuffer dst, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+        // The image must already be in TRANSFER_DST_OPTIMAL; layers are packed back to back in data.
+        void uploadToImage(VkImage image, const void* data, VkDeviceSize size, uint32_t width, uint32_t height, uint32_t layerCount);
+
+        // Reserves staging space for callers that want to fill it in place; returns the mapped pointer.
+        void* stage(VkDeviceSize size, VkBuffer& buffer, VkDeviceSize& offset);
+
+        void copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
+        void copyBufferToImage(VkBuffer buffer, VkDeviceSize bufferOffset, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
+        void transitionImageLayout(VkImage image, uint32_t layerCount, VkImageLayout oldLayout, VkImageLayout newLayout);
+
+        void submit();
+        void wait();
+        bool isComplete();
+        void submitAndWait() { submit(); wait(); }
+
+        VkCommandBuffer getCommandBuffer() const { return commandBuffer; }
+        uint32_t getCommandCount() const { return commandCount; }
+        bool usesTransferQueue() const { return useTransferQueue; }
+        // Graphics timeline value reached once the batch, including the acquire, has finished; 0 before submit().
+        uint64_t getTimelineValue() const { return timelineValue; }
+
+    private:
+        struct StagingChunk {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            MemoryAllocation memory;
+            VkDeviceSize size = 0;
+            VkDeviceSize used = 0;
+        };
+
+        void releaseStaging();
+        void recordOwnershipTransfer();
+        void freeCommandBuffers();
+
+        Device& device;
+        bool useTransferQueue;
+        VkCommandPool commandPool;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkCommandBuffer acquireCommandBuffer = VK_NULL_HANDLE;
+        uint64_t timelineValue = 0;
+        std::vector<VkBufferMemoryBarrier> bufferTransfers;
+        std::vector<VkImageMemoryBarrier> imageTransfers;
+        std::vector<StagingChunk> stagingChunks;
+        bool copiedBuffers = false;
+        VkDeviceSize stagingAlignment;
+        uint32_t commandCount = 0;
+        bool submitted = false;
+        bool completed = false;
+    };
+}
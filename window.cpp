@@ -4,13 +4,17 @@
 
 namespace vulkan {
 
-    Window::Window(int w, int h, std::string name) : width{ w }, height{ h }, windowName{ name } {
-        initWindow();
+    Window::Window(int w, int h, std::string name, bool headless) : width{ w }, height{ h }, headless{ headless }, windowName{ name } {
+        if (!headless) {
+            initWindow();
+        }
     }
 
     Window::~Window() {
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        if (window) {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
     }
 
     void Window::initWindow() {
@@ -24,6 +28,9 @@ namespace vulkan {
     }
 
     void Window::createWindowSurface(VkInstance instance, VkSurfaceKHR* surface) {
+        if (headless) {
+            throw std::runtime_error("headless window has no surface");
+        }
         if (glfwCreateWindowSurface(instance, window, nullptr, surface) != VK_SUCCESS) {
             throw std::runtime_error("failed to craete window surface");
         }
@@ -11,13 +11,15 @@ namespace vulkan {
 
 	class Window {
 	public:
-		Window(int w, int h, std::string name);
+		// A headless window opens nothing; its extent only sizes the offscreen images SwapChain renders into.
+		Window(int w, int h, std::string name, bool headless = false);
 		~Window();
 
 		Window(const Window&) = delete;
 		Window& operator=(const Window&) = delete;
 
-		bool shouldClose() { return glfwWindowShouldClose(window); }
+		bool shouldClose() { return window && glfwWindowShouldClose(window); }
+		bool isHeadless() const { return headless; }
 		VkExtent2D getExtent() { return { static_cast<uint32_t>(width), static_cast<uint32_t>(height) }; }
 		bool wasWindowResized() { return framebufferResized; }
 		void resetWindowResizedFlag() { framebufferResized = false; }
@@ -36,8 +38,9 @@ namespace vulkan {
 		int height;
 
 		bool framebufferResized = false;
+		bool headless;
 
 		std::string windowName;
-		GLFWwindow* window;
+		GLFWwindow* window = nullptr;
 	};
 }
\ No newline at end of file